@@ -6,6 +6,7 @@
 #include <sys/types.h>
 #include <semaphore.h>
 #include <pthread.h>
+#include <stdint.h>
 #include <signal.h>
 #include <fcntl.h>
 #include <sys/shm.h>
@@ -15,116 +16,39 @@
 #include <errno.h>    // Para manejo de errores con directorios
 
 #include "config.h"
+#include "tabla_cuentas.h"
+#include "persistencia.h"
+#include "wal.h"
+#include "escritura.h"
+#include "reloj.h"
+#include "registro.h"
+#include "eventos.h"
+#include "operaciones.h"
+#include "servidor.h"
+#include "pool.h"
 
 #define CUENTAS "cuentas.dat" 
 #define BUFFER_SIZE 1024 // Tamanio del buffer para la memoria compartida de cuentas
-#define MAX_HILOS 100 // Numero maximo de hilos permitidos
-#define DIR_TRANSACCIONES "transacciones" // Nombre del directorio de transacciones
 
-int numHilos = 0; 
-int contadorUsuarios = 0;
+int contadorUsuarios = 0; // sesiones admitidas, protegido por mutex_contador
+pthread_t hilo_escritura; // unico escritor de cuentas.dat
+pthread_t hilo_registro;  // unico escritor de los logs
+int registro_activo = 0;
+int modo_servidor = 0; // banco --servidor: sesiones por socket en lugar de terminales
 
-pthread_t hilos[MAX_HILOS];
+PoolHilos *pool_sesiones = NULL; // NUM_HILOS hilos fijos que atienden las sesiones
 pthread_mutex_t mutex_contador = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t mutex_log_gen = PTHREAD_MUTEX_INITIALIZER;
-
-// Estructura para representar la cuenta bancaria de un usuario 
-typedef struct
-{
-    int numero_cuenta;
-    char titular[100];
-    float saldo;
-    int pin;
-    int num_transacciones;
-    int bloqueado;
-} CuentaBancaria;
-
-// Estructura que contiene todas las cuenta del banco 
-typedef struct
-{
-    CuentaBancaria cuentas[100];
-    int num_cuentas;
-} TablaCuentas;
 
 sem_t semaforo;
 Config configuracion_sys;
-
-// Función para crear el directorio de transacciones si no existe
-// Verifica la existencia del directorio y lo crea con permisos 0700
-void crear_directorio_transacciones()
-{
-    struct stat st = {0};
-
-    if (stat(DIR_TRANSACCIONES, &st) == -1)
-    {
-        // El directorio no existe, intentamos crearlo
-        if (mkdir(DIR_TRANSACCIONES, 0700) == -1)
-        {
-            perror("Error al crear directorio de transacciones");
-         //   registro_log_general("Main", "Error al crear directorio transacciones");
-            exit(EXIT_FAILURE);
-        }
-        //registro_log_general("Main", "Directorio de transacciones creado");
-    }
-}
-
-// Función para verificar y crear el archivo de transacciones del usuario
-// Como parametro se pasa el numero de cuenta para que se cree el archivo 
-void crear_archivo_transacciones(int num_cuenta)
-{
-    char nombre_archivo[100];
-    snprintf(nombre_archivo, sizeof(nombre_archivo), "%s/transacciones_%d.log", DIR_TRANSACCIONES, num_cuenta);
-
-    // Verificar si el archivo ya existe
-    if (access(nombre_archivo, F_OK) != -1)
-    {
-        return; // El archivo ya existe, no necesitamos crearlo
-    }
-
-    // Crear el archivo
-    FILE *archivo = fopen(nombre_archivo, "w");
-    if (!archivo)
-    {
-        perror("Error al crear archivo de transacciones");
-       // registro_log_general("Transacciones", "Error al crear archivo de transacciones");
-        return;
-    }
-
-    fclose(archivo);
-
-    char log_msg[150];
-    snprintf(log_msg, sizeof(log_msg), "Archivo de transacciones creado para cuenta %d", num_cuenta);
-    //registro_log_general("Transacciones", log_msg);
-}
-
+TablaCuentas *tabla_shm = NULL; // Tabla de cuentas en memoria compartida
 
 // la funcion de registro_log_general registra los logs que ocurren en todo el sistema 
 // como parametro se pasa el tipo de operacion y una descripcion de que es lo que ocurre junto con la fecha 
+// la fecha y el formato los pone el hilo de escritura de logs
 void registro_log_general(const char *tipo, const char *descripcion)
 {
-    pthread_mutex_lock(&mutex_log_gen); // bloqueo para acceso a zona critica
-
-    FILE *log_gen = fopen("application.log", "a");
-    if (!log_gen)
-    {
-        perror("Error al abrir application.log");
-        pthread_mutex_unlock(&mutex_log_gen);
-        registro_log_general("Main", "Error al abrir application.log");
-       // return;
-    }
-
-    // Obtener fecha y hora actual 
-    time_t t = time(NULL);
-    struct tm *tm_info = localtime(&t);
-    char fecha_hora[30];
-    strftime(fecha_hora, sizeof(fecha_hora), "%Y-%m-%d %H:%M:%S", tm_info);
-
-    fprintf(log_gen, "[%s] | Operación: %s | Descripcion: %s\n",
-            fecha_hora, tipo, descripcion);
-
-    fclose(log_gen);
-    // libera el mutex 
-    pthread_mutex_unlock(&mutex_log_gen);
+    registro_anotar(LOG_BANCO, 0, tipo, descripcion, 0, 0);
 }
 
 // init banco se encarga de inicializar el sistema del banco
@@ -133,8 +57,6 @@ void init_banco()
     sem_init(&semaforo, 1, 1);
     printf("=== Banco inciado ===\n");
     registro_log_general("Main", "Banco iniciado");
-    // Crear el directorio de transacciones al iniciar el banco
-    crear_directorio_transacciones();
 }
 
 // Funcion para mostrar el banner en la interfaz grafica 
@@ -196,20 +118,22 @@ int login()
     int numero_cuenta = 0, intentos = 3;
     int pin;
 
-    // Acceso a la memoria compartida
-    key_t key = ftok("cuentas.dat", 65);
-    int shm_id = shmget(key, sizeof(TablaCuentas), 0666);
-    TablaCuentas *tabla = (TablaCuentas *)shmat(shm_id, NULL, 0);
+    // Acceso a la memoria compartida creada al iniciar el banco
+    TablaCuentas *tabla = tabla_shm;
 
     // Mostrar las cuentas disponibles y cargadas en la memoria compartida tras acceder a ella 
     printf("\n ==== Cuentas disponibles ====\n");
     printf("Numero | Titular | Saldo\n");
-    for (int i = 0; i < tabla->num_cuentas; i++)
+    // lectura sin cerrojos: cada cuenta se copia de forma consistente con su secuencia
+    int num_cuentas = __atomic_load_n(&tabla->num_cuentas, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < num_cuentas; i++)
     {
+        CuentaBancaria cuenta;
+        tabla_leer_posicion(tabla, i, &cuenta);
         printf("%d | %s | %.2f\n",
-               tabla->cuentas[i].numero_cuenta,
-               tabla->cuentas[i].titular,
-               tabla->cuentas[i].saldo);
+               cuenta.numero_cuenta,
+               cuenta.titular,
+               cuenta.saldo);
     }
     printf("===================================\n");
 
@@ -221,25 +145,18 @@ int login()
         printf("Ingrese el PIN de la cuenta:\n");
         scanf("%d", &pin);
 
-        // busqueda de cuenta en la memoria compartida
+        // busqueda de cuenta en la memoria compartida mediante el indice
         int encontrada = 0;
-        for (int i = 0; i < tabla->num_cuentas; i++)
+        CuentaBancaria cuenta;
+        if (tabla_leer_cuenta(tabla, numero_cuenta, &cuenta) == 0 && cuenta.pin == pin)
         {
-            if (tabla->cuentas[i].numero_cuenta == numero_cuenta &&
-                tabla->cuentas[i].pin == pin)
-            {
-                encontrada = 1;
-                // Crear archivo de transacciones para el usuario si es su primer login
-                crear_archivo_transacciones(numero_cuenta);
-                break;
-            }
+            encontrada = 1;
         }
 
         if (encontrada)
         {
             printf("Cuenta encontrada. ¡Bienvenido!\n");
             registro_log_general("Login", "Login exitoso");
-            shmdt(tabla);
             return numero_cuenta;
         }
         else
@@ -252,28 +169,46 @@ int login()
 
     printf("Demasiados intentos. Vuelve más tarde.\n");
     registro_log_general("Login", "Demasiados intentos de login");
-    shmdt(tabla);
     return -1;
 }
 
-void *abrir_terminal(void *arg)
+// Admision de sesiones: reserva una plaza si no se ha llegado a NUM_HILOS
+// retorno de 0 si hay plaza, -1 si no
+int reservar_usuario()
 {
-    int *num_cuenta_ptr = (int *)arg;
-    int num_cuenta = *num_cuenta_ptr;
-    free(num_cuenta_ptr);
-
+    int admitido = -1;
     pthread_mutex_lock(&mutex_contador);
-    if (contadorUsuarios >= configuracion_sys.num_hilos)
+    if (contadorUsuarios < configuracion_sys.num_hilos)
     {
-        printf("Limite de usuarios alcanzado\n");
-        pthread_mutex_unlock(&mutex_contador);
-        pthread_exit(NULL);
-        registro_log_general("Main", "Limite de usuarios alcanzado");
+        contadorUsuarios++;
+        admitido = 0;
     }
-    contadorUsuarios++;
     pthread_mutex_unlock(&mutex_contador);
+    return admitido;
+}
+
+void liberar_usuario()
+{
+    pthread_mutex_lock(&mutex_contador);
+    contadorUsuarios--;
+    pthread_mutex_unlock(&mutex_contador);
+}
 
-    printf("Abriendo terminal. Usuarios activos: %d/%d\n", contadorUsuarios, configuracion_sys.num_hilos);
+int usuarios_activos()
+{
+    pthread_mutex_lock(&mutex_contador);
+    int activos = contadorUsuarios;
+    pthread_mutex_unlock(&mutex_contador);
+    return activos;
+}
+
+// Tarea del pool de sesiones: terminal con ./usuario para una cuenta
+// La plaza se reserva antes de encolarla y se libera al cerrar el terminal
+void abrir_terminal(void *arg)
+{
+    int num_cuenta = (int)(intptr_t)arg;
+
+    printf("Abriendo terminal. Usuarios activos: %d/%d\n", usuarios_activos(), configuracion_sys.num_hilos);
     registro_log_general("Main", "Abriendo terminal");
 
     // Preparar el comando con el número de cuenta
@@ -281,13 +216,12 @@ void *abrir_terminal(void *arg)
     snprintf(comando, sizeof(comando), "x-terminal-emulator -e ./usuario %d", num_cuenta);
 
     // Ejecutar el terminal con el número de cuenta como argumento
-    int status = system(comando);
-
-    pthread_mutex_lock(&mutex_contador);
-    contadorUsuarios--;
-    pthread_mutex_unlock(&mutex_contador);
+    if (system(comando) == -1)
+    {
+        perror("Error al abrir el terminal");
+    }
 
-    pthread_exit(NULL);
+    liberar_usuario();
 }
 
 // Funcion para gargar las cuentas desde el archivo cuentas.dat a la memoria compartida
@@ -305,9 +239,11 @@ void cargar_cuentas(TablaCuentas *tabla)
     tabla->num_cuentas = 0;
     CuentaBancaria temp;
 
+    indice_construir(tabla);
+
     while (fread(&temp, sizeof(CuentaBancaria), 1, file) == 1)
     {
-        if (tabla->num_cuentas >= 100)
+        if (tabla->num_cuentas >= tabla->capacidad)
         {
             printf("Limite de cuentas alcanzo\n");
             break;
@@ -319,8 +255,11 @@ void cargar_cuentas(TablaCuentas *tabla)
             continue;
         }
 
-        tabla->cuentas[tabla->num_cuentas] = temp;
-        tabla->num_cuentas++;
+        // copia en la tabla y alta en el indice hash
+        if (tabla_agregar_cuenta(tabla, temp) == -1)
+        {
+            printf("Cuenta duplicada encontrada: %d\n", temp.numero_cuenta);
+        }
     }
 
     fclose(file);
@@ -331,38 +270,133 @@ void cargar_cuentas(TablaCuentas *tabla)
     }
 }
 
+// Vuelca las cuentas pendientes y deja cuentas.dat en disco antes de salir
+void detener_persistencia()
+{
+    buffer_detener();
+    pthread_join(hilo_escritura, NULL);
+    persistencia_sincronizar();
+    persistencia_cerrar();
+    registro_log_general("Main", "Cuentas pendientes guardadas en disco");
+}
+
+// Vuelca las lineas de log pendientes de todos los procesos
+void detener_registro()
+{
+    if (!registro_activo)
+        return;
+    registro_detener();
+    pthread_join(hilo_registro, NULL);
+    registro_activo = 0;
+}
+
+// Modo servidor: las sesiones llegan por el socket SOCKET_BANCO y las
+// operaciones se ejecutan en este proceso, sin abrir terminales ni procesos usuario
+// Al recibir SIGINT o SIGTERM se guarda todo y el banco termina
+void ejecutar_servidor()
+{
+    if (wal_abrir(WAL, wal_modo(configuracion_sys.durabilidad)) == -1)
+    {
+        registro_log_general("Main", "Error al abrir el WAL para el servidor");
+        exit(EXIT_FAILURE);
+    }
+    operaciones_iniciar(tabla_shm, &configuracion_sys);
+
+    if (servidor_ejecutar(SOCKET_BANCO, pool_sesiones) == -1)
+    {
+        registro_log_general("Main", "Error al iniciar el servidor de sesiones");
+    }
+
+    printf("Cerrando el servidor....\n");
+    pool_detener(pool_sesiones);
+    servidor_cerrar_sesiones();
+    if (system("killall ./monitor") == -1)
+        perror("killall");
+    wal_cerrar();
+    detener_persistencia();
+    detener_registro();
+    exit(0);
+}
+
 // Funcion para la ejecucion del menu del banco 
 // Inicializamos el sistema, configuracion, carga de cuentas, monitor, menu 
 void *bucle_menu(void *arg)
 {
+    // anillo de logs compartido: los procesos dejan las lineas y un hilo del
+    // banco las escribe por lotes; si falla cada proceso escribe directamente
+    if (registro_crear() == 0 && pthread_create(&hilo_registro, NULL, registro_hilo_escritura, NULL) == 0)
+    {
+        registro_activo = 1;
+    }
+
     init_banco();
     print_banner();
 
     // Carga de la configuracion al sistema
     configuracion_sys = leer_configuracion("config.txt");
+    // ritmo de las pausas y hora de los logs (MODO_RELOJ)
+    reloj_iniciar(reloj_modo(configuracion_sys.modo_reloj));
+
+    // recuperacion: los cambios de saldo anotados en el WAL que no llegaron a
+    // cuentas.dat se aplican antes de publicar la tabla
+    if (persistencia_abrir(CUENTAS, SINC_NINGUNA) == -1)
+    {
+        registro_log_general("Main", "Error al abrir cuentas.dat para la recuperacion");
+        exit(EXIT_FAILURE);
+    }
+    int recuperados = wal_recuperar(WAL);
+    persistencia_cerrar();
+    if (recuperados > 0)
+    {
+        printf("Recuperados %d cambios de saldo desde %s\n", recuperados, WAL);
+        registro_log_general("Main", "Cambios de saldo recuperados del WAL");
+    }
+
+    // estado compartido del commit en grupo del WAL
+    if (wal_crear_estado() == -1)
+    {
+        registro_log_general("Main", "Error al crear el estado compartido del WAL");
+        exit(EXIT_FAILURE);
+    }
 
     // configuracion de la memoria compartida en el banco
-    key_t key = ftok("cuentas.dat", 65);
-    if (key == -1)
+    // la capacidad inicial sale del numero de registros de cuentas.dat o de config.txt
+    struct stat st_cuentas;
+    int capacidad = configuracion_sys.capacidad_cuentas;
+    if (stat(CUENTAS, &st_cuentas) == 0 && st_cuentas.st_size / (off_t)sizeof(CuentaBancaria) > capacidad)
+    {
+        capacidad = st_cuentas.st_size / sizeof(CuentaBancaria);
+    }
+
+    tabla_shm = tabla_crear(capacidad, configuracion_sys.paginas_grandes);
+    if (tabla_shm == NULL)
     {
-        perror("ftok");
+        registro_log_general("Main", "Error al crear la memoria compartida de cuentas");
         exit(EXIT_FAILURE);
     }
+    cargar_cuentas(tabla_shm);
 
-    int shm_id = shmget(key, sizeof(TablaCuentas), IPC_CREAT | 0666);
-    if (shm_id == -1)
+    // servicio de persistencia: un unico hilo escribe en cuentas.dat las
+    // cuentas que los usuarios marcan en el buffer compartido
+    if (persistencia_abrir(CUENTAS, persistencia_politica(configuracion_sys.sincronizacion_cuentas)) == -1 ||
+        buffer_crear(tabla_shm) == -1)
     {
-        perror("shmget");
+        registro_log_general("Main", "Error al crear el buffer de escritura");
+        exit(EXIT_FAILURE);
+    }
+    if (pthread_create(&hilo_escritura, NULL, buffer_hilo_escritura, NULL) != 0)
+    {
+        perror("Error al crear el hilo de escritura");
+        registro_log_general("Main", "Error al crear el hilo de escritura");
         exit(EXIT_FAILURE);
     }
 
-    TablaCuentas *tabla = (TablaCuentas *)shmat(shm_id, NULL, 0);
-    if (tabla == (void *)-1)
+    // anillo de eventos de operaciones que los usuarios publican para el monitor
+    if (eventos_crear() == -1)
     {
-        perror("shmat");
+        registro_log_general("Main", "Error al crear el anillo de eventos");
         exit(EXIT_FAILURE);
     }
-    cargar_cuentas(tabla);
 
     if (configuracion_sys.num_hilos <= 0)
     {
@@ -376,15 +410,29 @@ void *bucle_menu(void *arg)
     if (pid == 0)
     {
         comprobacion_anomalias();
+        _exit(0);
+    }
+
+    // hilos fijos para las sesiones: terminales en el modo menu, peticiones en el modo servidor
+    pool_sesiones = pool_crear(configuracion_sys.num_hilos, modo_servidor ? MAX_SESIONES_COLA : configuracion_sys.num_hilos);
+    if (pool_sesiones == NULL)
+    {
+        registro_log_general("Main", "Error al crear el pool de sesiones");
+        exit(EXIT_FAILURE);
+    }
+
+    if (modo_servidor)
+    {
+        ejecutar_servidor();
     }
 
     // Bucle principal del menu 
     while (1)
     {
-        sleep(2);
+        pausa(2);
         int opcion = 0;
 
-        printf("Actualmente hay %d/%d usuarios abiertos.\n", contadorUsuarios, configuracion_sys.num_hilos);
+        printf("Actualmente hay %d/%d usuarios abiertos.\n", usuarios_activos(), configuracion_sys.num_hilos);
         printf("1.Acceder al sistema\n");
         printf("2.Cerrar\n");
         scanf("%d", &opcion);
@@ -401,38 +449,27 @@ void *bucle_menu(void *arg)
             }
 
             // Si el login es exitoso, abrir terminal con el número de cuenta
-            if (contadorUsuarios < configuracion_sys.num_hilos)
+            // en uno de los hilos del pool si queda plaza
+            if (reservar_usuario() == 0)
             {
-                // Pasar el número de cuenta como argumento
-                int *num_cuenta_ptr = malloc(sizeof(int));
-                *num_cuenta_ptr = num_cuenta;
-
-                pthread_t thread;
-                if (pthread_create(&thread, NULL, abrir_terminal, num_cuenta_ptr) != 0)
-                {
-                    perror("Error al crear hijo");
-                    registro_log_general("Main", "Error al abrir terminal");
-                    free(num_cuenta_ptr);
-                }
-                else
-                {
-                    hilos[numHilos++] = thread;
-                }
+                pool_enviar(pool_sesiones, abrir_terminal, (void *)(intptr_t)num_cuenta);
             }
             else
             {
                 printf("Se ha alcanzado el numero de usuarios maximo (%d)", configuracion_sys.num_hilos);
                 registro_log_general("Main", "Numero de usuarios max. alcanzado");
             }
-            sleep(2);
+            pausa(2);
             break;
 
         case 2:
             printf("Cerrando todos los terminales....\n");
             registro_log_general("Main", "Cerrando terminales");
-            sleep(2);
+            pausa(2);
             int cerrar_usuario = system("killall ./usuario");
             int cerrar_monitor = system("killall ./monitor");
+            detener_persistencia();
+            detener_registro();
             int cerrar_banco = system("killall ./banco");
             printf("Saliendo.......\n");
             registro_log_general("Main", "Salida del sistema");
@@ -448,8 +485,15 @@ void *bucle_menu(void *arg)
 }
 
 // inicio del hilo del prograna donde se ejecuta el menu del banco 
-int main()
+// Uso: banco              menu y un terminal con ./usuario por sesion
+//      banco --servidor   sesiones por el socket banco.sock (cliente)
+int main(int argc, char *argv[])
 {
+    if (argc > 1 && strcmp(argv[1], "--servidor") == 0)
+    {
+        modo_servidor = 1;
+    }
+
     pthread_t hilo_bucle;
     if (pthread_create(&hilo_bucle, NULL, bucle_menu, NULL) != 0)
     {
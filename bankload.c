@@ -0,0 +1,448 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <dirent.h>
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+#include "config.h"
+#include "tabla_cuentas.h"
+#include "persistencia.h"
+#include "wal.h"
+#include "escritura.h"
+#include "reloj.h"
+#include "registro.h"
+#include "eventos.h"
+#include "historial.h"
+#include "operaciones.h"
+#include "ejecutor.h"
+#include "histograma.h"
+
+#define CUENTAS "cuentas.dat"
+#define CHECKPOINT_MONITOR "monitor.ckpt"
+#define CUENTA_BASE_CARGA 100000   // numero de la primera cuenta sintetica
+#define SALDO_INICIAL_CARGA 10000.0f
+#define PIN_CARGA 1111
+#define IMPORTE_MAXIMO_CARGA 50    // importes enteros de 1 a este valor: las sumas en float son exactas
+#define MAX_CLIENTES_CARGA 1024
+#define TIPOS_OPERACION 4
+
+typedef struct
+{
+    int cuentas;
+    int clientes;
+    double duracion;  // s
+    double tasa;      // ops/s entre todos los clientes, 0 = lo mas rapido posible
+    double zipf;      // exponente de popularidad de las cuentas, 0 = uniforme
+    int mezcla[TIPOS_OPERACION]; // peso de cada TipoOperacion
+} ParametrosCarga;
+
+// Cliente sintetico: un hilo que ejecuta operaciones con ejecutar_operacion
+// Cada uno acumula sus propios histogramas y contadores, sin compartir nada
+typedef struct
+{
+    int indice;
+    pthread_t hilo;
+    unsigned long long semilla;
+    Histograma latencias[TIPOS_OPERACION];
+    long fallidas[TIPOS_OPERACION];
+    long long depositado; // importe de los depositos correctos
+    long long retirado;   // importe de los retiros correctos
+} ClienteCarga;
+
+static const char *nombres_tipo[TIPOS_OPERACION] = {"deposito", "retiro", "transferencia", "consulta"};
+
+Config configuracion_sys;
+static ParametrosCarga parametros = {1000, 8, 10.0, 0.0, 0.0, {30, 30, 30, 10}};
+static ClienteCarga clientes[MAX_CLIENTES_CARGA];
+static double *popularidad = NULL; // distribucion acumulada de Zipf por cuenta
+static int importe_maximo = IMPORTE_MAXIMO_CARGA;
+static long long inicio_carga;
+static long long fin_carga;
+
+static long long ahora_ns()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+// xorshift64*, un generador por cliente
+static unsigned long long aleatorio(unsigned long long *estado)
+{
+    *estado ^= *estado >> 12;
+    *estado ^= *estado << 25;
+    *estado ^= *estado >> 27;
+    return *estado * 2685821657736338717ULL;
+}
+
+// Numero en [0, 1)
+static double aleatorio_unidad(unsigned long long *estado)
+{
+    return (aleatorio(estado) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Distribucion acumulada de Zipf: la cuenta de rango k tiene peso 1/k^s
+static int preparar_zipf(int cuentas, double exponente)
+{
+    popularidad = malloc(cuentas * sizeof(double));
+    if (popularidad == NULL)
+    {
+        perror("malloc popularidad");
+        return -1;
+    }
+    double suma = 0;
+    for (int k = 0; k < cuentas; k++)
+    {
+        suma += 1.0 / pow(k + 1, exponente);
+        popularidad[k] = suma;
+    }
+    for (int k = 0; k < cuentas; k++)
+        popularidad[k] /= suma;
+    return 0;
+}
+
+// Posicion de la cuenta elegida, de 0 a cuentas-1
+static int elegir_cuenta(unsigned long long *estado)
+{
+    double u = aleatorio_unidad(estado);
+    if (popularidad == NULL)
+        return (int)(u * parametros.cuentas);
+
+    // primera cuenta cuya probabilidad acumulada supera u
+    int bajo = 0, alto = parametros.cuentas - 1;
+    while (bajo < alto)
+    {
+        int medio = (bajo + alto) / 2;
+        if (popularidad[medio] > u)
+            alto = medio;
+        else
+            bajo = medio + 1;
+    }
+    return bajo;
+}
+
+static TipoOperacion elegir_tipo(unsigned long long *estado)
+{
+    int total = 0;
+    for (int i = 0; i < TIPOS_OPERACION; i++)
+        total += parametros.mezcla[i];
+    int valor = aleatorio(estado) % total;
+    for (int i = 0; i < TIPOS_OPERACION; i++)
+    {
+        if (valor < parametros.mezcla[i])
+            return (TipoOperacion)i;
+        valor -= parametros.mezcla[i];
+    }
+    return OPERACION_CONSULTA;
+}
+
+// Bucle de un cliente
+// Con tasa fija (lazo abierto) cada cliente tiene su calendario de envios y la
+// latencia se mide desde el instante previsto, no desde el envio real: si el
+// sistema se retrasa el retraso cuenta, como en los histogramas HDR
+// Sin tasa (lazo cerrado) cada cliente envia la siguiente al terminar la anterior
+static void *hilo_cliente(void *arg)
+{
+    ClienteCarga *cliente = (ClienteCarga *)arg;
+    long long intervalo = parametros.tasa > 0 ? (long long)(parametros.clientes * 1e9 / parametros.tasa) : 0;
+    long long prevista = inicio_carga + (intervalo ? (long long)(cliente->indice * 1e9 / parametros.tasa) : 0);
+
+    while (1)
+    {
+        long long comienzo;
+        if (intervalo)
+        {
+            if (prevista >= fin_carga)
+                break;
+            struct timespec espera = {prevista / 1000000000LL, prevista % 1000000000LL};
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &espera, NULL) != 0)
+                ;
+            comienzo = prevista;
+            prevista += intervalo;
+        }
+        else
+        {
+            comienzo = ahora_ns();
+            if (comienzo >= fin_carga)
+                break;
+        }
+
+        DescriptorOperacion operacion = {.tipo = elegir_tipo(&cliente->semilla)};
+        int origen = elegir_cuenta(&cliente->semilla);
+        operacion.numero_cuenta = CUENTA_BASE_CARGA + origen;
+        operacion.cantidad = 1 + aleatorio(&cliente->semilla) % importe_maximo;
+        if (operacion.tipo == OPERACION_TRANSFERENCIA)
+        {
+            int destino = elegir_cuenta(&cliente->semilla);
+            if (destino == origen)
+                destino = (destino + 1) % parametros.cuentas;
+            operacion.cuenta_destino = CUENTA_BASE_CARGA + destino;
+        }
+
+        ejecutar_operacion(&operacion);
+        histograma_anotar(&cliente->latencias[operacion.tipo], ahora_ns() - comienzo);
+
+        if (operacion.codigo != OP_CORRECTA)
+            cliente->fallidas[operacion.tipo]++;
+        else if (operacion.tipo == OPERACION_DEPOSITO)
+            cliente->depositado += (long long)operacion.cantidad;
+        else if (operacion.tipo == OPERACION_RETIRO)
+            cliente->retirado += (long long)operacion.cantidad;
+    }
+    return NULL;
+}
+
+// Suma los saldos de las cuentas sinteticas
+// retorno de -1 si falta alguna cuenta
+static int sumar_saldos(TablaCuentas *tabla, double *total)
+{
+    *total = 0;
+    for (int i = 0; i < parametros.cuentas; i++)
+    {
+        CuentaBancaria cuenta;
+        if (tabla_leer_cuenta(tabla, CUENTA_BASE_CARGA + i, &cuenta) == -1)
+        {
+            printf("Falta la cuenta %d, cree las cuentas con --crear %d\n", CUENTA_BASE_CARGA + i, parametros.cuentas);
+            return -1;
+        }
+        *total += cuenta.saldo;
+    }
+    return 0;
+}
+
+// Borra el directorio del historial por cuenta con sus segmentos e indice
+// retorno de 0 si se borra o no existia, -1 en caso de error
+static int borrar_historial()
+{
+    DIR *dir = opendir(DIR_HISTORIAL);
+    if (dir == NULL)
+    {
+        if (errno == ENOENT)
+            return 0;
+        perror("Error al abrir el historial");
+        return -1;
+    }
+
+    struct dirent *entrada;
+    char ruta[512];
+    while ((entrada = readdir(dir)) != NULL)
+    {
+        if (strcmp(entrada->d_name, ".") == 0 || strcmp(entrada->d_name, "..") == 0)
+            continue;
+        snprintf(ruta, sizeof(ruta), "%s/%s", DIR_HISTORIAL, entrada->d_name);
+        if (unlink(ruta) == -1)
+        {
+            perror("Error al borrar el historial");
+            closedir(dir);
+            return -1;
+        }
+    }
+    closedir(dir);
+
+    if (rmdir(DIR_HISTORIAL) == -1)
+    {
+        perror("Error al borrar el historial");
+        return -1;
+    }
+    return 0;
+}
+
+// Escribe cuentas.dat con las cuentas sinteticas; el banco debe estar parado
+// El WAL, el historial por cuenta y el estado guardado del monitor son de las
+// cuentas anteriores y se eliminan con ellas
+static int crear_cuentas(int num_cuentas)
+{
+    FILE *archivo = fopen(CUENTAS, "wb");
+    if (archivo == NULL)
+    {
+        perror("Error al crear el archivo de cuentas");
+        return -1;
+    }
+    for (int i = 0; i < num_cuentas; i++)
+    {
+        CuentaBancaria cuenta = {CUENTA_BASE_CARGA + i, "", SALDO_INICIAL_CARGA, PIN_CARGA, 0, 0};
+        snprintf(cuenta.titular, sizeof(cuenta.titular), "Cliente de carga %d", i);
+        fwrite(&cuenta, sizeof(cuenta), 1, archivo);
+    }
+    if (fclose(archivo) != 0)
+    {
+        perror("Error al escribir el archivo de cuentas");
+        return -1;
+    }
+    unlink(WAL);
+    unlink(CHECKPOINT_MONITOR);
+    if (borrar_historial() == -1)
+        return -1;
+
+    printf("Creadas %d cuentas (%d a %d) con %.2f de saldo y PIN %d\n", num_cuentas, CUENTA_BASE_CARGA,
+           CUENTA_BASE_CARGA + num_cuentas - 1, SALDO_INICIAL_CARGA, PIN_CARGA);
+    return 0;
+}
+
+static void imprimir_latencias(const char *nombre, const Histograma *h, long fallidas, double segundos)
+{
+    printf("%-14s %10llu %8ld %10.0f %9.1f %9.1f %9.1f %9.1f\n", nombre, h->total, fallidas,
+           h->total / segundos, histograma_percentil(h, 50) / 1e3, histograma_percentil(h, 99) / 1e3,
+           histograma_percentil(h, 99.9) / 1e3, h->maximo / 1e3);
+}
+
+static void uso(const char *programa)
+{
+    printf("Uso: %s --crear N                 crea N cuentas sinteticas (banco parado)\n", programa);
+    printf("     %s [opciones]               genera carga contra el banco en marcha\n", programa);
+    printf("  --cuentas N        cuentas sinteticas que se usan (%d)\n", parametros.cuentas);
+    printf("  --clientes M       clientes concurrentes (%d)\n", parametros.clientes);
+    printf("  --duracion S       segundos de carga (%.0f)\n", parametros.duracion);
+    printf("  --tasa R           ops/s en total a ritmo fijo; sin ella, lo mas rapido posible\n");
+    printf("  --zipf S           popularidad de Zipf con exponente S; sin ella, uniforme\n");
+    printf("  --mezcla D,R,T,C   pesos de deposito, retiro, transferencia y consulta (30,30,30,10)\n");
+}
+
+// Generador de carga: cuentas sinteticas y clientes concurrentes con una mezcla
+// de operaciones, en lazo abierto o cerrado, con histogramas de latencia y
+// comprobacion de que el dinero se conserva
+int main(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *valor = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--crear") == 0 && valor)
+        {
+            int num_cuentas = atoi(argv[++i]);
+            if (num_cuentas < 2 || num_cuentas > CAPACIDAD_MAXIMA)
+            {
+                uso(argv[0]);
+                exit(1);
+            }
+            exit(crear_cuentas(num_cuentas) == -1 ? 1 : 0);
+        }
+        else if (strcmp(argv[i], "--cuentas") == 0 && valor)
+            parametros.cuentas = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--clientes") == 0 && valor)
+            parametros.clientes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--duracion") == 0 && valor)
+            parametros.duracion = atof(argv[++i]);
+        else if (strcmp(argv[i], "--tasa") == 0 && valor)
+            parametros.tasa = atof(argv[++i]);
+        else if (strcmp(argv[i], "--zipf") == 0 && valor)
+            parametros.zipf = atof(argv[++i]);
+        else if (strcmp(argv[i], "--mezcla") == 0 && valor &&
+                 sscanf(argv[++i], "%d,%d,%d,%d", &parametros.mezcla[0], &parametros.mezcla[1],
+                        &parametros.mezcla[2], &parametros.mezcla[3]) == 4)
+            ;
+        else
+        {
+            uso(argv[0]);
+            exit(1);
+        }
+    }
+    int pesos = parametros.mezcla[0] + parametros.mezcla[1] + parametros.mezcla[2] + parametros.mezcla[3];
+    if (parametros.cuentas < 2 || parametros.clientes < 1 || parametros.clientes > MAX_CLIENTES_CARGA ||
+        parametros.duracion <= 0 || parametros.tasa < 0 || parametros.zipf < 0 || pesos <= 0 ||
+        parametros.mezcla[0] < 0 || parametros.mezcla[1] < 0 || parametros.mezcla[2] < 0 || parametros.mezcla[3] < 0)
+    {
+        uso(argv[0]);
+        exit(1);
+    }
+
+    configuracion_sys = leer_configuracion("config.txt");
+    reloj_iniciar(reloj_modo(configuracion_sys.modo_reloj));
+    if (configuracion_sys.limite_retiro > 0 && configuracion_sys.limite_retiro < importe_maximo)
+        importe_maximo = configuracion_sys.limite_retiro;
+    if (configuracion_sys.limite_tranferencia > 0 && configuracion_sys.limite_tranferencia < importe_maximo)
+        importe_maximo = configuracion_sys.limite_tranferencia;
+
+    // el mismo acceso al banco que usuario
+    registro_adjuntar();
+    TablaCuentas *tabla = tabla_adjuntar();
+    if (tabla == NULL ||
+        persistencia_abrir(CUENTAS, persistencia_politica(configuracion_sys.sincronizacion_cuentas)) == -1 ||
+        wal_abrir(WAL, wal_modo(configuracion_sys.durabilidad)) == -1)
+    {
+        printf("No se puede acceder al banco, ¿esta en marcha?\n");
+        exit(1);
+    }
+    eventos_adjuntar();
+    if (buffer_adjuntar(tabla) == -1)
+        exit(1);
+    operaciones_iniciar(tabla, &configuracion_sys);
+
+    if (parametros.zipf > 0 && preparar_zipf(parametros.cuentas, parametros.zipf) == -1)
+        exit(1);
+
+    double saldo_inicial;
+    if (sumar_saldos(tabla, &saldo_inicial) == -1)
+        exit(1);
+
+    printf("Carga: %d cuentas, %d clientes, %.0f s, %s, cuentas %s, mezcla %d/%d/%d/%d\n",
+           parametros.cuentas, parametros.clientes, parametros.duracion,
+           parametros.tasa > 0 ? "ritmo fijo" : "lo mas rapido posible",
+           parametros.zipf > 0 ? "Zipf" : "uniformes", parametros.mezcla[0], parametros.mezcla[1],
+           parametros.mezcla[2], parametros.mezcla[3]);
+    if (parametros.tasa > 0)
+        printf("Tasa objetivo: %.0f ops/s\n", parametros.tasa);
+
+    // margen para que todos los hilos esten creados antes del primer envio
+    inicio_carga = ahora_ns() + 10000000LL;
+    fin_carga = inicio_carga + (long long)(parametros.duracion * 1e9);
+    for (int i = 0; i < parametros.clientes; i++)
+    {
+        clientes[i].indice = i;
+        clientes[i].semilla = 0x9E3779B97F4A7C15ULL * (i + 1);
+        for (int t = 0; t < TIPOS_OPERACION; t++)
+            histograma_iniciar(&clientes[i].latencias[t]);
+        if (pthread_create(&clientes[i].hilo, NULL, hilo_cliente, &clientes[i]) != 0)
+        {
+            perror("pthread_create cliente");
+            exit(1);
+        }
+    }
+
+    Histograma por_tipo[TIPOS_OPERACION], total;
+    long fallidas[TIPOS_OPERACION] = {0}, fallidas_total = 0;
+    long long depositado = 0, retirado = 0;
+    histograma_iniciar(&total);
+    for (int t = 0; t < TIPOS_OPERACION; t++)
+        histograma_iniciar(&por_tipo[t]);
+
+    for (int i = 0; i < parametros.clientes; i++)
+    {
+        pthread_join(clientes[i].hilo, NULL);
+        for (int t = 0; t < TIPOS_OPERACION; t++)
+        {
+            histograma_sumar(&por_tipo[t], &clientes[i].latencias[t]);
+            histograma_sumar(&total, &clientes[i].latencias[t]);
+            fallidas[t] += clientes[i].fallidas[t];
+            fallidas_total += clientes[i].fallidas[t];
+        }
+        depositado += clientes[i].depositado;
+        retirado += clientes[i].retirado;
+    }
+    double segundos = (ahora_ns() - inicio_carga) / 1e9;
+
+    printf("\n%-14s %10s %8s %10s %9s %9s %9s %9s\n", "operacion", "total", "fallidas", "ops/s",
+           "p50 us", "p99 us", "p99.9 us", "max us");
+    for (int t = 0; t < TIPOS_OPERACION; t++)
+        if (parametros.mezcla[t] > 0)
+            imprimir_latencias(nombres_tipo[t], &por_tipo[t], fallidas[t], segundos);
+    imprimir_latencias("total", &total, fallidas_total, segundos);
+
+    // las transferencias no cambian el total; depositos y retiros si
+    double saldo_final;
+    if (sumar_saldos(tabla, &saldo_final) == -1)
+        exit(1);
+    double esperado = saldo_inicial + depositado - retirado;
+    double descuadre = saldo_final - esperado;
+    printf("\nDinero: inicial %.2f + depositos %lld - retiros %lld = esperado %.2f, final %.2f: %s\n",
+           saldo_inicial, depositado, retirado, esperado, saldo_final,
+           descuadre > -0.005 && descuadre < 0.005 ? "se conserva" : "DESCUADRE");
+
+    free(popularidad);
+    wal_cerrar();
+    persistencia_cerrar();
+    tabla_desadjuntar(tabla);
+    return descuadre > -0.005 && descuadre < 0.005 ? 0 : 2;
+}
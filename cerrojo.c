@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include "cerrojo.h"
+
+// Inicializa un cerrojo compartido entre procesos y robusto
+void cerrojo_init(Cerrojo *cerrojo)
+{
+    pthread_mutexattr_t atributos;
+    pthread_mutexattr_init(&atributos);
+    pthread_mutexattr_setpshared(&atributos, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&atributos, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&cerrojo->mutex, &atributos);
+    pthread_mutexattr_destroy(&atributos);
+}
+
+// Bloquea el cerrojo
+// Si el anterior propietario murio con el cerrojo tomado se marca como
+// consistente y se continua: los datos protegidos se reescriben completos
+// retorno de 1 si el cerrojo se ha recuperado de un proceso terminado, 0 si no
+int cerrojo_bloquear(Cerrojo *cerrojo)
+{
+    int resultado = pthread_mutex_lock(&cerrojo->mutex);
+    if (resultado == EOWNERDEAD)
+    {
+        fprintf(stderr, "[AVISO] Cerrojo recuperado de un proceso terminado\n");
+        pthread_mutex_consistent(&cerrojo->mutex);
+        return 1;
+    }
+    return 0;
+}
+
+void cerrojo_desbloquear(Cerrojo *cerrojo)
+{
+    pthread_mutex_unlock(&cerrojo->mutex);
+}
+
+// Inicializa una variable de condicion compartida entre procesos
+void condicion_init(pthread_cond_t *condicion)
+{
+    pthread_condattr_t atributos;
+    pthread_condattr_init(&atributos);
+    pthread_condattr_setpshared(&atributos, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_setclock(&atributos, CLOCK_MONOTONIC);
+    pthread_cond_init(condicion, &atributos);
+    pthread_condattr_destroy(&atributos);
+}
+
+// Espera en la condicion con el cerrojo tomado como mucho los milisegundos indicados
+// retorno de 0 si se recibe aviso, ETIMEDOUT si vence el plazo
+int cerrojo_esperar(Cerrojo *cerrojo, pthread_cond_t *condicion, int milisegundos)
+{
+    struct timespec limite;
+    clock_gettime(CLOCK_MONOTONIC, &limite);
+    limite.tv_sec += milisegundos / 1000;
+    limite.tv_nsec += (long)(milisegundos % 1000) * 1000000L;
+    if (limite.tv_nsec >= 1000000000L)
+    {
+        limite.tv_sec++;
+        limite.tv_nsec -= 1000000000L;
+    }
+
+    int resultado = pthread_cond_timedwait(condicion, &cerrojo->mutex, &limite);
+    if (resultado == EOWNERDEAD)
+    {
+        fprintf(stderr, "[AVISO] Cerrojo recuperado de un proceso terminado\n");
+        pthread_mutex_consistent(&cerrojo->mutex);
+        resultado = 0;
+    }
+    return resultado;
+}
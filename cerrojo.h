@@ -0,0 +1,21 @@
+#ifndef CERROJO_H
+#define CERROJO_H
+
+#include <pthread.h>
+
+// Cerrojo en memoria compartida entre procesos
+// Es un mutex robusto: sin contencion no sale del espacio de usuario y,
+// si el proceso que lo tiene muere, el siguiente que lo pide lo recupera
+typedef struct
+{
+    pthread_mutex_t mutex;
+} Cerrojo;
+
+void cerrojo_init(Cerrojo *cerrojo);
+int cerrojo_bloquear(Cerrojo *cerrojo);
+void cerrojo_desbloquear(Cerrojo *cerrojo);
+
+void condicion_init(pthread_cond_t *condicion);
+int cerrojo_esperar(Cerrojo *cerrojo, pthread_cond_t *condicion, int milisegundos);
+
+#endif
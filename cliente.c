@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "servidor.h"
+
+// Cliente de terminal para el banco en modo servidor (banco --servidor)
+// Pide los datos por teclado, envia una linea por operacion y muestra la respuesta
+// Uso: cliente [socket]   (por defecto banco.sock)
+
+static FILE *conexion = NULL;
+
+// Envia la peticion y espera su linea de respuesta
+// retorno de 1 si la respuesta es OK, 0 si es un error, -1 si se ha perdido la conexion
+static int peticion(const char *linea, char *respuesta, size_t tam)
+{
+    if (fputs(linea, conexion) == EOF || fflush(conexion) == EOF || fgets(respuesta, tam, conexion) == NULL)
+    {
+        printf("Conexion con el banco perdida\n");
+        return -1;
+    }
+    respuesta[strcspn(respuesta, "\n")] = '\0';
+    return strncmp(respuesta, "OK", 2) == 0;
+}
+
+static int conectar(const char *ruta)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+    {
+        perror("socket");
+        return -1;
+    }
+
+    struct sockaddr_un direccion = {0};
+    direccion.sun_family = AF_UNIX;
+    strncpy(direccion.sun_path, ruta, sizeof(direccion.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *)&direccion, sizeof(direccion)) == -1)
+    {
+        perror("Error al conectar con el banco");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *ruta = argc > 1 ? argv[1] : SOCKET_BANCO;
+    int fd = conectar(ruta);
+    if (fd == -1)
+        exit(1);
+    conexion = fdopen(fd, "r+");
+
+    char linea[TAM_LINEA_SESION];
+    char respuesta[TAM_LINEA_SESION];
+    int r = 0;
+
+    // autenticacion, el servidor corta tras INTENTOS_LOGIN fallos
+    while (r != 1)
+    {
+        int cuenta, pin;
+        printf("Ingrese el número de cuenta: \n");
+        if (scanf("%d", &cuenta) != 1)
+            exit(1);
+        printf("Ingrese el PIN de la cuenta:\n");
+        if (scanf("%d", &pin) != 1)
+            exit(1);
+
+        snprintf(linea, sizeof(linea), "LOGIN %d %d\n", cuenta, pin);
+        r = peticion(linea, respuesta, sizeof(respuesta));
+        if (r == -1)
+            exit(1);
+        printf("%s\n", r ? "Cuenta encontrada. ¡Bienvenido!" : respuesta + 6);
+    }
+
+    int opcion = 0;
+    while (opcion != 5)
+    {
+        printf("¿Qué quieres hacer en tu cuenta?\n");
+        printf("1. Depositar dinero \n");
+        printf("2. Retirar dinero \n");
+        printf("3. Hacer transferencia \n");
+        printf("4. Consultar saldo \n");
+        printf("5. Salir \n");
+        if (scanf("%d", &opcion) != 1)
+            break;
+
+        float cantidad;
+        int destino;
+        switch (opcion)
+        {
+        case 1:
+            printf("¿Cuánto dinero quiere depositar?\n");
+            scanf("%f", &cantidad);
+            snprintf(linea, sizeof(linea), "DEPOSITAR %.2f\n", cantidad);
+            break;
+        case 2:
+            printf("¿Cuánto dinero quiere retirar?\n");
+            scanf("%f", &cantidad);
+            snprintf(linea, sizeof(linea), "RETIRAR %.2f\n", cantidad);
+            break;
+        case 3:
+            printf("Introduzca la cuenta destino: ");
+            scanf("%d", &destino);
+            printf("Ingrese la cantidad a transferir: ");
+            scanf("%f", &cantidad);
+            snprintf(linea, sizeof(linea), "TRANSFERIR %d %.2f\n", destino, cantidad);
+            break;
+        case 4:
+            snprintf(linea, sizeof(linea), "SALDO\n");
+            break;
+        case 5:
+            snprintf(linea, sizeof(linea), "SALIR\n");
+            break;
+        default:
+            printf("Introduzca una opción válida por favor\n");
+            continue;
+        }
+
+        r = peticion(linea, respuesta, sizeof(respuesta));
+        if (r == -1)
+            break;
+        if (r == 0)
+            printf("%s\n", respuesta + 6);
+        else if (opcion == 4)
+            printf("Saldo y datos de la cuenta: %s\n", respuesta + 3);
+        else if (opcion != 5)
+            printf("Operación realizada. Nuevo saldo: %s\n", respuesta + 3);
+    }
+
+    printf("Saliendo.......\n");
+    fclose(conexion);
+    return 0;
+}
@@ -21,9 +21,19 @@ Config leer_configuracion(const char *ruta) {
         if (sscanf(linea, "LIMITE_TRANSFERENCIA=%d", &config.limite_tranferencia) == 1) continue;
         if (sscanf(linea, "UMBRAL_RETIROS=%d", &config.umbral_retiros) == 1) continue;
         if (sscanf(linea, "UMBRAL_TRANSFERENCIAS=%d", &config.umbral_tranferencias) == 1) continue;
+        if (sscanf(linea, "VENTANA_ANOMALIAS=%d", &config.ventana_anomalias) == 1) continue;
+        if (sscanf(linea, "VENTANA_GRAFO=%d", &config.ventana_grafo) == 1) continue;
+        if (sscanf(linea, "UMBRAL_DISPERSION=%d", &config.umbral_dispersion) == 1) continue;
+        if (sscanf(linea, "UMBRAL_CONCENTRACION=%d", &config.umbral_concentracion) == 1) continue;
         if (sscanf(linea, "NUM_HILOS=%d", &config.num_hilos) == 1) continue;
+        if (sscanf(linea, "CAPACIDAD_CUENTAS=%d", &config.capacidad_cuentas) == 1) continue;
+        if (sscanf(linea, "PAGINAS_GRANDES=%d", &config.paginas_grandes) == 1) continue;
         if (sscanf(linea, "ARCHIVO_CUENTAS=%49s", config.archivo_cuentas) == 1) continue;
         if (sscanf(linea, "ARCHIVO_LOG=%49s", config.archivo_log) == 1) continue;
+        if (sscanf(linea, "ARCHIVO_REGLAS=%49s", config.archivo_reglas) == 1) continue;
+        if (sscanf(linea, "SINCRONIZACION_CUENTAS=%15s", config.sincronizacion_cuentas) == 1) continue;
+        if (sscanf(linea, "DURABILIDAD=%15s", config.durabilidad) == 1) continue;
+        if (sscanf(linea, "MODO_RELOJ=%15s", config.modo_reloj) == 1) continue;
     } 
 
     fclose(archivo);
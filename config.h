@@ -7,9 +7,19 @@ typedef struct
     int limite_tranferencia;
     int umbral_retiros;
     int umbral_tranferencias;
+    int ventana_anomalias;
+    int ventana_grafo;
+    int umbral_dispersion;
+    int umbral_concentracion;
     int num_hilos;
+    int capacidad_cuentas;
+    int paginas_grandes;
     char archivo_cuentas[50];
     char archivo_log[50];
+    char archivo_reglas[50];
+    char sincronizacion_cuentas[16];
+    char durabilidad[16];
+    char modo_reloj[16];
 } Config;
 
 Config leer_configuracion(const char *ruta);
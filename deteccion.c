@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "deteccion.h"
+#include "indice_cuentas.h"
+
+// Deteccion de anomalias con reglas de ventanas de tiempo
+// Las reglas llegan compiladas en una tabla por operacion: una transaccion
+// solo se compara con las reglas de su operacion y las operaciones sin
+// reglas no cuestan nada. Cada cuenta tiene su estado en una posicion fija
+// que da indice_cuentas; procesar una transaccion es una busqueda y unas
+// pocas sumas por regla, independiente del numero de cuentas activas.
+// Las entradas sin actividad durante la mayor ventana caducan y se liberan
+
+// Estado local del monitor
+static TablaReglas reglas;
+static IndiceCuentas indice;
+static EstadoCuenta *cuentas = NULL;      // por posicion del indice
+static EstadoRegla *estados_cuenta = NULL; // reglas.num_cuenta estados por entrada de cuentas[]
+static EstadoRegla estados_global[MAX_REGLAS];
+static int ventana_maxima = 0;             // mayor ventana de las reglas de ambito cuenta
+
+static void vaciar_estado(EstadoRegla *estado)
+{
+    estado->alerta_hasta = 0;
+    for (int i = 0; i < NUM_CUBETAS; i++)
+        estado->cubetas[i].periodo = -1;
+}
+
+static int caducada_en(const EstadoCuenta *e, long long marca)
+{
+    return marca - e->ultima_actividad > ventana_maxima;
+}
+
+static int caducada(int posicion, long long marca)
+{
+    return caducada_en(&cuentas[posicion], marca);
+}
+
+static void liberar(int posicion)
+{
+    cuentas[posicion].ocupada = 0;
+}
+
+// Reserva la tabla de estados para las reglas compiladas
+// retorno de 0 si todo va bien, -1 en caso de error
+int deteccion_iniciar(const TablaReglas *tabla)
+{
+    reglas = *tabla;
+
+    cuentas = calloc(MAX_CUENTAS_VIGILADAS, sizeof(EstadoCuenta));
+    if (cuentas == NULL)
+    {
+        perror("calloc estado de deteccion");
+        return -1;
+    }
+    if (reglas.num_cuenta > 0)
+    {
+        estados_cuenta = calloc((size_t)MAX_CUENTAS_VIGILADAS * reglas.num_cuenta, sizeof(EstadoRegla));
+        if (estados_cuenta == NULL)
+        {
+            perror("calloc estado de reglas");
+            return -1;
+        }
+    }
+
+    if (indice_iniciar(&indice, MAX_CUENTAS_VIGILADAS, caducada, liberar) == -1)
+        return -1;
+
+    // una ventana mas corta que las cubetas dejaria cubetas de 0 segundos
+    ventana_maxima = 0;
+    for (int i = 0; i < reglas.num_reglas; i++)
+    {
+        Regla *r = &reglas.reglas[i];
+        if (r->ventana < NUM_CUBETAS)
+            r->ventana = NUM_CUBETAS;
+        if (r->ambito == AMBITO_CUENTA && r->ventana > ventana_maxima)
+            ventana_maxima = r->ventana;
+    }
+    for (int i = 0; i < reglas.num_global; i++)
+        vaciar_estado(&estados_global[i]);
+    return 0;
+}
+
+// Estado de la cuenta, se crea si no existe
+// retorno de la posicion en cuentas[], -1 si la tabla esta llena de cuentas activas
+static int estado_de(int numero_cuenta, long long marca)
+{
+    int nueva;
+    int posicion = indice_alta(&indice, numero_cuenta, marca, &nueva);
+    if (posicion == -1 || !nueva)
+        return posicion;
+
+    cuentas[posicion].ocupada = 1;
+    cuentas[posicion].numero_cuenta = numero_cuenta;
+    cuentas[posicion].ultima_actividad = marca;
+    for (int i = 0; i < reglas.num_cuenta; i++)
+        vaciar_estado(&estados_cuenta[(size_t)posicion * reglas.num_cuenta + i]);
+    return posicion;
+}
+
+// Suma la transaccion en la cubeta de su periodo y devuelve los totales de
+// las cubetas que caen dentro de la ventana que termina en ese periodo
+static void acumular(EstadoRegla *estado, const Regla *r, const RegistroTx *tx, int *operaciones, float *importe)
+{
+    long long periodo = tx->marca / (r->ventana / NUM_CUBETAS);
+    CubetaRegla *c = &estado->cubetas[periodo % NUM_CUBETAS];
+    if (c->periodo != periodo)
+    {
+        c->periodo = periodo;
+        c->operaciones = 0;
+        c->importe = 0;
+    }
+    c->operaciones++;
+    c->importe += tx->monto;
+
+    *operaciones = 0;
+    *importe = 0;
+    for (int i = 0; i < NUM_CUBETAS; i++)
+    {
+        const CubetaRegla *v = &estado->cubetas[i];
+        if (v->periodo <= periodo - NUM_CUBETAS || v->periodo > periodo)
+            continue;
+        *operaciones += v->operaciones;
+        *importe += v->importe;
+    }
+}
+
+// Actualiza el estado de las reglas de la operacion y comprueba sus umbrales
+// Una regla no repite la alerta para la misma cuenta hasta que pasa su ventana
+// retorno del numero de alertas generadas en alertas[]
+int deteccion_procesar(const RegistroTx *tx, Alerta *alertas)
+{
+    if (tx->operacion < 1 || tx->operacion > MAX_OPERACION)
+        return 0;
+
+    int desde = reglas.desde[tx->operacion];
+    int hasta = reglas.desde[tx->operacion + 1];
+    int entrada = -2; // la cuenta se busca solo si hay alguna regla de ambito cuenta
+    int num_alertas = 0;
+
+    for (int i = desde; i < hasta; i++)
+    {
+        const Regla *r = &reglas.reglas[i];
+        EstadoRegla *estado;
+        if (r->ambito == AMBITO_GLOBAL)
+        {
+            estado = &estados_global[r->ranura];
+        }
+        else
+        {
+            if (entrada == -2)
+            {
+                entrada = estado_de(tx->numero_cuenta, tx->marca);
+                if (entrada != -1 && tx->marca > cuentas[entrada].ultima_actividad)
+                    cuentas[entrada].ultima_actividad = tx->marca;
+            }
+            if (entrada == -1)
+                continue;
+            estado = &estados_cuenta[(size_t)entrada * reglas.num_cuenta + r->ranura];
+        }
+
+        int operaciones;
+        float importe;
+        acumular(estado, r, tx, &operaciones, &importe);
+
+        if ((r->min_operaciones == 0 || operaciones >= r->min_operaciones) &&
+            (r->min_importe == 0 || importe >= r->min_importe) && tx->marca >= estado->alerta_hasta)
+        {
+            int cuenta = r->ambito == AMBITO_GLOBAL ? 0 : tx->numero_cuenta;
+            alertas[num_alertas++] = (Alerta){r, cuenta, operaciones, importe};
+            estado->alerta_hasta = tx->marca + r->ventana;
+        }
+    }
+    return num_alertas;
+}
+
+// Escribe las reglas y el estado de las cuentas no caducadas en la marca
+// retorno de 0 si todo va bien, -1 en caso de error
+int deteccion_guardar(FILE *archivo, long long marca)
+{
+    int activas = 0;
+    for (int i = 0; i < MAX_CUENTAS_VIGILADAS; i++)
+    {
+        if (cuentas[i].ocupada && !caducada_en(&cuentas[i], marca))
+            activas++;
+    }
+
+    if (fwrite(&reglas.num_reglas, sizeof(int), 1, archivo) != 1 ||
+        fwrite(reglas.reglas, sizeof(Regla), reglas.num_reglas, archivo) != (size_t)reglas.num_reglas ||
+        fwrite(estados_global, sizeof(EstadoRegla), reglas.num_global, archivo) != (size_t)reglas.num_global ||
+        fwrite(&activas, sizeof(int), 1, archivo) != 1)
+        return -1;
+
+    for (int i = 0; i < MAX_CUENTAS_VIGILADAS; i++)
+    {
+        if (!cuentas[i].ocupada || caducada_en(&cuentas[i], marca))
+            continue;
+        if (fwrite(&cuentas[i], sizeof(EstadoCuenta), 1, archivo) != 1 ||
+            fwrite(&estados_cuenta[(size_t)i * reglas.num_cuenta], sizeof(EstadoRegla), reglas.num_cuenta,
+                   archivo) != (size_t)reglas.num_cuenta)
+            return -1;
+    }
+    return 0;
+}
+
+// Recupera el estado guardado por deteccion_guardar
+// El estado solo vale si las reglas no han cambiado desde que se guardo
+// retorno de 0 si se ha recuperado, -1 si no (se empieza sin estado)
+int deteccion_cargar(FILE *archivo, long long marca)
+{
+    int num_reglas, activas;
+    Regla guardadas[MAX_REGLAS];
+    EstadoRegla globales[MAX_REGLAS];
+    if (fread(&num_reglas, sizeof(int), 1, archivo) != 1 || num_reglas != reglas.num_reglas ||
+        fread(guardadas, sizeof(Regla), num_reglas, archivo) != (size_t)num_reglas ||
+        memcmp(guardadas, reglas.reglas, num_reglas * sizeof(Regla)) != 0 ||
+        fread(globales, sizeof(EstadoRegla), reglas.num_global, archivo) != (size_t)reglas.num_global ||
+        fread(&activas, sizeof(int), 1, archivo) != 1)
+        return -1;
+    memcpy(estados_global, globales, reglas.num_global * sizeof(EstadoRegla));
+
+    for (int i = 0; i < activas; i++)
+    {
+        EstadoCuenta e;
+        EstadoRegla estados[MAX_REGLAS];
+        if (fread(&e, sizeof(EstadoCuenta), 1, archivo) != 1 ||
+            fread(estados, sizeof(EstadoRegla), reglas.num_cuenta, archivo) != (size_t)reglas.num_cuenta)
+            return -1;
+
+        int entrada = estado_de(e.numero_cuenta, marca);
+        if (entrada == -1)
+            continue;
+        cuentas[entrada] = e;
+        memcpy(&estados_cuenta[(size_t)entrada * reglas.num_cuenta], estados, reglas.num_cuenta * sizeof(EstadoRegla));
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef DETECCION_H
+#define DETECCION_H
+
+#include <stdio.h>
+#include "txlog.h"
+#include "reglas.h"
+
+#define MAX_CUENTAS_VIGILADAS (1 << 16) // cuentas con estado a la vez (potencia de 2)
+#define NUM_CUBETAS 6                   // cubetas en que se divide la ventana de cada regla
+#define MAX_ALERTAS_EVENTO MAX_REGLAS   // alertas que puede generar una transaccion
+
+// Contadores de una cubeta de la ventana de una regla
+typedef struct
+{
+    long long periodo; // numero de cubeta desde epoch (marca / tam_cubeta)
+    int operaciones;
+    float importe;
+} CubetaRegla;
+
+// Estado de una regla para una cuenta (o para todo el banco si es global)
+// La ventana se divide en cubetas; una cubeta de un periodo antiguo no cuenta
+// y se reutiliza al llegar su turno, asi la memoria por regla es fija
+typedef struct
+{
+    long long alerta_hasta; // marca hasta la que no se repite la alerta
+    CubetaRegla cubetas[NUM_CUBETAS];
+} EstadoRegla;
+
+// Entrada de una cuenta en la tabla de deteccion; sus estados de regla estan
+// en un vector aparte, uno por cada regla de ambito cuenta
+typedef struct
+{
+    int ocupada;
+    int numero_cuenta;
+    long long ultima_actividad; // marca de la ultima transaccion, para expirar la entrada
+} EstadoCuenta;
+
+typedef struct
+{
+    const Regla *regla;
+    int numero_cuenta; // 0 en las reglas globales
+    int operaciones;   // operaciones de la regla dentro de la ventana
+    float importe;     // importe de esas operaciones
+} Alerta;
+
+int deteccion_iniciar(const TablaReglas *tabla);
+int deteccion_procesar(const RegistroTx *tx, Alerta *alertas);
+int deteccion_guardar(FILE *archivo, long long marca);
+int deteccion_cargar(FILE *archivo, long long marca);
+
+#endif
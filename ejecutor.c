@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include "ejecutor.h"
+#include "operaciones.h"
+#include "wal.h"
+
+// Aplica la operacion y la anota en el WAL sin esperar a que llegue a disco
+// lsn recibe lo que hay que esperar para confirmarla, 0 si nada
+static void aplicar_operacion(DescriptorOperacion *operacion, unsigned long long *lsn)
+{
+    *lsn = 0;
+    switch (operacion->tipo)
+    {
+    case OPERACION_DEPOSITO:
+        operacion->codigo = operacion_depositar_sin_esperar(operacion->numero_cuenta, operacion->cantidad,
+                                                            &operacion->cuenta, lsn);
+        break;
+    case OPERACION_RETIRO:
+        operacion->codigo = operacion_retirar_sin_esperar(operacion->numero_cuenta, operacion->cantidad,
+                                                          &operacion->cuenta, lsn);
+        break;
+    case OPERACION_TRANSFERENCIA:
+        operacion->codigo = operacion_transferir_sin_esperar(operacion->numero_cuenta, operacion->cuenta_destino,
+                                                             operacion->cantidad, &operacion->cuenta, lsn);
+        break;
+    case OPERACION_CONSULTA:
+        operacion->codigo = operacion_consultar(operacion->numero_cuenta, &operacion->cuenta);
+        break;
+    default:
+        operacion->codigo = OP_IMPORTE_NO_VALIDO;
+        break;
+    }
+}
+
+// Ejecuta la operacion en el hilo que llama y deja el resultado en el descriptor
+// Vuelve con la operacion confirmada en el WAL
+void ejecutar_operacion(DescriptorOperacion *operacion)
+{
+    unsigned long long lsn;
+    aplicar_operacion(operacion, &lsn);
+    wal_esperar(lsn);
+}
+
+// Trabajador de la sesion: aplica en orden todas las operaciones enviadas
+// hasta el momento y espera una sola vez al WAL por el lsn mas alto, asi una
+// ventana de hasta MAX_OPERACIONES_PENDIENTES operaciones paga un fdatasync.
+// Los resultados se publican despues de esa espera, nunca antes.
+// Los descriptores de la ventana son solo suyos hasta que los cuenta como ejecutados
+static void *hilo_ejecutor(void *arg)
+{
+    EjecutorOperaciones *ejecutor = (EjecutorOperaciones *)arg;
+
+    pthread_mutex_lock(&ejecutor->mutex);
+    while (1)
+    {
+        while (ejecutor->ejecutadas == ejecutor->enviadas && !ejecutor->parar)
+            pthread_cond_wait(&ejecutor->hay_operaciones, &ejecutor->mutex);
+        if (ejecutor->ejecutadas == ejecutor->enviadas)
+            break; // parar y nada pendiente
+
+        unsigned long desde = ejecutor->ejecutadas;
+        unsigned long hasta = ejecutor->enviadas;
+        pthread_mutex_unlock(&ejecutor->mutex);
+
+        unsigned long long lsn_maximo = 0;
+        unsigned long anotadas = 0;
+        for (unsigned long i = desde; i < hasta; i++)
+        {
+            unsigned long long lsn;
+            aplicar_operacion(&ejecutor->operaciones[i % MAX_OPERACIONES_PENDIENTES], &lsn);
+            if (lsn != 0)
+                anotadas++;
+            if (lsn > lsn_maximo)
+                lsn_maximo = lsn;
+        }
+        wal_esperar(lsn_maximo);
+
+        pthread_mutex_lock(&ejecutor->mutex);
+        ejecutor->ejecutadas = hasta;
+        ejecutor->anotadas += anotadas;
+        if (lsn_maximo != 0)
+            ejecutor->esperas_wal++;
+        pthread_cond_signal(&ejecutor->hay_resultados);
+    }
+    pthread_mutex_unlock(&ejecutor->mutex);
+    return NULL;
+}
+
+// Prepara el ejecutor de una sesion, con o sin trabajador propio
+// retorno de 0 si todo va bien, -1 si no se puede crear el hilo
+int ejecutor_iniciar(EjecutorOperaciones *ejecutor, int con_hilo)
+{
+    memset(ejecutor, 0, sizeof(*ejecutor));
+    pthread_mutex_init(&ejecutor->mutex, NULL);
+    pthread_cond_init(&ejecutor->hay_operaciones, NULL);
+    pthread_cond_init(&ejecutor->hay_resultados, NULL);
+    ejecutor->con_hilo = con_hilo;
+
+    if (!con_hilo)
+        return 0;
+
+    // el trabajador no atiende senales: le llegan al hilo de la sesion, que
+    // decide cuando parar entre operaciones
+    sigset_t todas, anteriores;
+    sigfillset(&todas);
+    pthread_sigmask(SIG_BLOCK, &todas, &anteriores);
+    int resultado = pthread_create(&ejecutor->hilo, NULL, hilo_ejecutor, ejecutor);
+    pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
+    if (resultado != 0)
+    {
+        fprintf(stderr, "pthread_create ejecutor: %s\n", strerror(resultado));
+        ejecutor->con_hilo = 0;
+        return -1;
+    }
+    return 0;
+}
+
+// Envia una operacion; sin trabajador queda ejecutada al volver
+// retorno de 0 si todo va bien, -1 si hay MAX_OPERACIONES_PENDIENTES sin recoger
+int ejecutor_enviar(EjecutorOperaciones *ejecutor, const DescriptorOperacion *operacion)
+{
+    pthread_mutex_lock(&ejecutor->mutex);
+    if (ejecutor->enviadas - ejecutor->recogidas == MAX_OPERACIONES_PENDIENTES)
+    {
+        pthread_mutex_unlock(&ejecutor->mutex);
+        return -1;
+    }
+    DescriptorOperacion *destino = &ejecutor->operaciones[ejecutor->enviadas % MAX_OPERACIONES_PENDIENTES];
+    *destino = *operacion;
+
+    if (!ejecutor->con_hilo)
+    {
+        ejecutar_operacion(destino);
+        ejecutor->ejecutadas++;
+        if (destino->tipo != OPERACION_CONSULTA && destino->codigo == OP_CORRECTA)
+        {
+            ejecutor->anotadas++;
+            ejecutor->esperas_wal++;
+        }
+    }
+    ejecutor->enviadas++;
+    pthread_cond_signal(&ejecutor->hay_operaciones);
+    pthread_mutex_unlock(&ejecutor->mutex);
+    return 0;
+}
+
+// Espera a la operacion enviada mas antigua y copia su resultado
+// retorno de 0 si todo va bien, -1 si no hay operaciones pendientes
+int ejecutor_esperar(EjecutorOperaciones *ejecutor, DescriptorOperacion *resultado)
+{
+    pthread_mutex_lock(&ejecutor->mutex);
+    if (ejecutor->recogidas == ejecutor->enviadas)
+    {
+        pthread_mutex_unlock(&ejecutor->mutex);
+        return -1;
+    }
+    while (ejecutor->ejecutadas == ejecutor->recogidas)
+        pthread_cond_wait(&ejecutor->hay_resultados, &ejecutor->mutex);
+
+    *resultado = ejecutor->operaciones[ejecutor->recogidas % MAX_OPERACIONES_PENDIENTES];
+    ejecutor->recogidas++;
+    pthread_mutex_unlock(&ejecutor->mutex);
+    return 0;
+}
+
+// Operaciones enviadas que aun no se han recogido
+int ejecutor_pendientes(EjecutorOperaciones *ejecutor)
+{
+    pthread_mutex_lock(&ejecutor->mutex);
+    int pendientes = (int)(ejecutor->enviadas - ejecutor->recogidas);
+    pthread_mutex_unlock(&ejecutor->mutex);
+    return pendientes;
+}
+
+// Operaciones ya ejecutadas que se pueden recoger sin esperar
+int ejecutor_terminadas(EjecutorOperaciones *ejecutor)
+{
+    pthread_mutex_lock(&ejecutor->mutex);
+    int terminadas = (int)(ejecutor->ejecutadas - ejecutor->recogidas);
+    pthread_mutex_unlock(&ejecutor->mutex);
+    return terminadas;
+}
+
+// Termina las operaciones enviadas y para el trabajador
+// Los resultados sin recoger se descartan
+void ejecutor_detener(EjecutorOperaciones *ejecutor)
+{
+    if (ejecutor->con_hilo)
+    {
+        pthread_mutex_lock(&ejecutor->mutex);
+        ejecutor->parar = 1;
+        pthread_cond_signal(&ejecutor->hay_operaciones);
+        pthread_mutex_unlock(&ejecutor->mutex);
+        pthread_join(ejecutor->hilo, NULL);
+        ejecutor->con_hilo = 0;
+    }
+    pthread_mutex_destroy(&ejecutor->mutex);
+    pthread_cond_destroy(&ejecutor->hay_operaciones);
+    pthread_cond_destroy(&ejecutor->hay_resultados);
+}
@@ -0,0 +1,59 @@
+#ifndef EJECUTOR_H
+#define EJECUTOR_H
+
+#include <pthread.h>
+#include "tabla_cuentas.h"
+
+#define MAX_OPERACIONES_PENDIENTES 64 // operaciones enviadas sin recoger por sesion
+
+typedef enum
+{
+    OPERACION_DEPOSITO,
+    OPERACION_RETIRO,
+    OPERACION_TRANSFERENCIA,
+    OPERACION_CONSULTA
+} TipoOperacion;
+
+// Descriptor de una operacion: la peticion y, al terminar, su resultado
+typedef struct
+{
+    TipoOperacion tipo;
+    int numero_cuenta;
+    int cuenta_destino;    // solo transferencias
+    float cantidad;
+    int codigo;            // OP_* de operaciones.h
+    CuentaBancaria cuenta; // cuenta de origen tras la operacion
+} DescriptorOperacion;
+
+// Ejecutor de las operaciones de una sesion
+// Sin hilo cada operacion se ejecuta al enviarla; con hilo un trabajador
+// persistente las ejecuta en orden mientras la sesion sigue enviando, por
+// ventanas que comparten una sola espera del WAL.
+// Los descriptores estan reservados en el anillo y se recogen en el orden
+// de envio; con el anillo lleno hay que recoger antes de enviar otra
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t hay_operaciones;
+    pthread_cond_t hay_resultados;
+    DescriptorOperacion operaciones[MAX_OPERACIONES_PENDIENTES];
+    unsigned long enviadas;
+    unsigned long ejecutadas;
+    unsigned long recogidas;
+    unsigned long anotadas;    // operaciones que escribieron en el WAL
+    unsigned long esperas_wal; // esperas al WAL que las confirmaron
+    int con_hilo;
+    int parar;
+    pthread_t hilo;
+} EjecutorOperaciones;
+
+void ejecutar_operacion(DescriptorOperacion *operacion);
+
+int ejecutor_iniciar(EjecutorOperaciones *ejecutor, int con_hilo);
+int ejecutor_enviar(EjecutorOperaciones *ejecutor, const DescriptorOperacion *operacion);
+int ejecutor_esperar(EjecutorOperaciones *ejecutor, DescriptorOperacion *resultado);
+int ejecutor_pendientes(EjecutorOperaciones *ejecutor);
+int ejecutor_terminadas(EjecutorOperaciones *ejecutor);
+void ejecutor_detener(EjecutorOperaciones *ejecutor);
+
+#endif
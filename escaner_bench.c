@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "txlog.h"
+#include "escaner_log.h"
+
+#define MB_GENERADOS 256 // tamanio del log sintetico si no se indica fichero
+#define LOG_SINTETICO "escaner_bench.log"
+
+static double segundos()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// Genera un log de texto con el formato de transacciones.log
+static int generar_log(const char *ruta, long mb)
+{
+    FILE *archivo = fopen(ruta, "w");
+    if (archivo == NULL)
+    {
+        perror("Error al crear el log sintetico");
+        return -1;
+    }
+
+    long long escritos = 0;
+    long long marca = time(NULL) - 30 * 24 * 3600;
+    char linea[256];
+    srand(1);
+    while (escritos < mb * 1024 * 1024)
+    {
+        RegistroTx r = {marca++, 1000 + rand() % 9000, 0, 1 + rand() % 4,
+                        (rand() % 500000) / 100.0f, (rand() % 10000000) / 100.0f};
+        int n = txlog_formatear(&r, linea, sizeof(linea));
+        fwrite(linea, 1, n, archivo);
+        escritos += n;
+    }
+    fclose(archivo);
+    return 0;
+}
+
+// Lectura clasica del monitor: fgets y sscanf con conjuntos de caracteres
+static long long leer_con_sscanf(const char *ruta, double *suma)
+{
+    FILE *archivo = fopen(ruta, "r");
+    if (archivo == NULL)
+        return -1;
+
+    char linea[256], fecha[50], tipo_op[50];
+    int cuenta;
+    float monto, saldo;
+    long long registros = 0;
+    while (fgets(linea, sizeof(linea), archivo))
+    {
+        if (sscanf(linea, "[%[^]]] Cuenta: %d | Operación: %[^|] | Monto: %f | Saldo final: %f",
+                   fecha, &cuenta, tipo_op, &monto, &saldo) == 5)
+        {
+            registros++;
+            *suma += monto;
+        }
+    }
+    fclose(archivo);
+    return registros;
+}
+
+// Mide el rendimiento del escaner de logs de texto frente a fgets + sscanf
+// Uso: escaner-bench [fichero.log]   (sin fichero genera uno de MB_GENERADOS MB)
+int main(int argc, char *argv[])
+{
+    const char *ruta = argc > 1 ? argv[1] : LOG_SINTETICO;
+    if (argc <= 1 && generar_log(ruta, MB_GENERADOS) == -1)
+        exit(1);
+
+    EscanerLog escaner;
+    RegistroTx registro;
+    double suma = 0;
+    long long registros = 0;
+
+    double inicio = segundos();
+    if (escaner_abrir(&escaner, ruta) == -1)
+        exit(1);
+    while (escaner_siguiente(&escaner, &registro))
+    {
+        registros++;
+        suma += registro.monto;
+    }
+    double t_escaner = segundos() - inicio;
+    size_t tam = escaner.tam;
+    long long descartadas = escaner.descartadas;
+    escaner_cerrar(&escaner);
+
+    double suma_sscanf = 0;
+    inicio = segundos();
+    long long registros_sscanf = leer_con_sscanf(ruta, &suma_sscanf);
+    double t_sscanf = segundos() - inicio;
+
+    double gb = tam / 1e9;
+    printf("Fichero: %s (%.1f MB)\n", ruta, tam / 1e6);
+    printf("escaner:       %lld registros, %lld descartadas, %.3f s, %.2f GB/s, %.1f M lineas/s (monto %.2f)\n",
+           registros, descartadas, t_escaner, gb / t_escaner, registros / t_escaner / 1e6, suma);
+    printf("fgets+sscanf:  %lld registros, %.3f s, %.2f GB/s (monto %.2f)\n",
+           registros_sscanf, t_sscanf, gb / t_sscanf, suma_sscanf);
+    return 0;
+}
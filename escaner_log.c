@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "escaner_log.h"
+
+// El fichero se mapea entero y se recorre con memchr (vectorizado en glibc)
+// para encontrar fin de linea y separadores; los numeros se convierten a mano
+// sin sscanf ni locale y la fecha solo pasa por mktime una vez por hora
+
+// Mapea el log para leerlo de principio a fin
+// retorno de 0 si todo va bien, -1 en caso de error
+int escaner_abrir(EscanerLog *escaner, const char *ruta)
+{
+    memset(escaner, 0, sizeof(*escaner));
+
+    int fd = open(ruta, O_RDONLY);
+    if (fd == -1)
+    {
+        perror("Error al abrir el log de transacciones");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+
+    escaner->tam = st.st_size;
+    if (escaner->tam > 0)
+    {
+        void *datos = mmap(NULL, escaner->tam, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (datos == MAP_FAILED)
+        {
+            perror("mmap");
+            close(fd);
+            return -1;
+        }
+        madvise(datos, escaner->tam, MADV_SEQUENTIAL);
+        escaner->datos = datos;
+    }
+    close(fd);
+    return 0;
+}
+
+void escaner_cerrar(EscanerLog *escaner)
+{
+    if (escaner->datos != NULL)
+        munmap((void *)escaner->datos, escaner->tam);
+    escaner->datos = NULL;
+}
+
+// Compara el literal con el texto y avanza si coincide
+static int literal(const char **p, const char *fin, const char *texto, size_t n)
+{
+    if ((size_t)(fin - *p) < n || memcmp(*p, texto, n) != 0)
+        return 0;
+    *p += n;
+    return 1;
+}
+
+static int digitos(const char *p, int n)
+{
+    int valor = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (p[i] < '0' || p[i] > '9')
+            return -1;
+        valor = valor * 10 + (p[i] - '0');
+    }
+    return valor;
+}
+
+static int entero(const char **p, const char *fin, int *valor)
+{
+    const char *q = *p;
+    int negativo = q < fin && *q == '-';
+    if (negativo)
+        q++;
+    if (q == fin || *q < '0' || *q > '9')
+        return 0;
+
+    long v = 0;
+    while (q < fin && *q >= '0' && *q <= '9')
+        v = v * 10 + (*q++ - '0');
+    *valor = negativo ? -v : v;
+    *p = q;
+    return 1;
+}
+
+static int decimal(const char **p, const char *fin, float *valor)
+{
+    const char *q = *p;
+    int negativo = q < fin && *q == '-';
+    if (negativo)
+        q++;
+    if (q == fin || *q < '0' || *q > '9')
+        return 0;
+
+    double v = 0;
+    while (q < fin && *q >= '0' && *q <= '9')
+        v = v * 10 + (*q++ - '0');
+    if (q < fin && *q == '.')
+    {
+        double escala = 1;
+        q++;
+        while (q < fin && *q >= '0' && *q <= '9')
+        {
+            v = v * 10 + (*q++ - '0');
+            escala *= 10;
+        }
+        v /= escala;
+    }
+    *valor = negativo ? -v : v;
+    *p = q;
+    return 1;
+}
+
+// Segundos desde epoch de "AAAA-MM-DD hh:mm:ss" en hora local
+// retorno de -1 si la fecha no es valida
+static long long convertir_fecha(EscanerLog *escaner, const char *f)
+{
+    int minuto = digitos(f + 14, 2), segundo = digitos(f + 17, 2);
+    if (f[4] != '-' || f[7] != '-' || f[10] != ' ' || f[13] != ':' || f[16] != ':' || minuto < 0 || segundo < 0)
+        return -1;
+
+    if (memcmp(f, escaner->hora, sizeof(escaner->hora)) != 0)
+    {
+        struct tm tm_info = {0};
+        tm_info.tm_year = digitos(f, 4) - 1900;
+        tm_info.tm_mon = digitos(f + 5, 2) - 1;
+        tm_info.tm_mday = digitos(f + 8, 2);
+        tm_info.tm_hour = digitos(f + 11, 2);
+        tm_info.tm_isdst = -1;
+        if (tm_info.tm_year < 0 || tm_info.tm_mon < 0 || tm_info.tm_mday < 0 || tm_info.tm_hour < 0)
+            return -1;
+        escaner->marca_hora = mktime(&tm_info);
+        memcpy(escaner->hora, f, sizeof(escaner->hora));
+    }
+    return escaner->marca_hora + minuto * 60 + segundo;
+}
+
+static int operacion_de(const char *nombre, size_t n)
+{
+    // el log antiguo dejaba un espacio antes del separador
+    while (n > 0 && nombre[n - 1] == ' ')
+        n--;
+
+    for (int op = TX_DEPOSITO; op <= TX_TRANSFERENCIA_RECIBIDA; op++)
+    {
+        const char *texto = txlog_nombre_operacion(op);
+        if (strlen(texto) == n && memcmp(texto, nombre, n) == 0)
+            return op;
+    }
+    return -1;
+}
+
+// Convierte una linea (sin el salto) en un registro
+// retorno de 1 si la linea tiene el formato, 0 si no
+static int convertir_linea(EscanerLog *escaner, const char *p, const char *fin, RegistroTx *registro)
+{
+    if (fin - p < 21 || p[0] != '[' || p[20] != ']')
+        return 0;
+    registro->marca = convertir_fecha(escaner, p + 1);
+    if (registro->marca == -1)
+        return 0;
+    p += 21;
+
+    if (!literal(&p, fin, " Cuenta: ", 9) || !entero(&p, fin, &registro->numero_cuenta) ||
+        !literal(&p, fin, " | Operación: ", 15))
+        return 0;
+
+    const char *separador = memchr(p, '|', fin - p);
+    if (separador == NULL)
+        return 0;
+    registro->operacion = operacion_de(p, separador - p);
+    p = separador;
+
+    if (registro->operacion == -1 || !literal(&p, fin, "| Monto: ", 9) || !decimal(&p, fin, &registro->monto) ||
+        !literal(&p, fin, " | Saldo final: ", 16) || !decimal(&p, fin, &registro->saldo))
+        return 0;
+
+    registro->contraparte = 0; // el formato de texto no la incluye
+    return 1;
+}
+
+// Siguiente registro del log; las lineas con otro formato se saltan y se cuentan
+// retorno de 1 si hay registro, 0 al llegar al final
+int escaner_siguiente(EscanerLog *escaner, RegistroTx *registro)
+{
+    while (escaner->pos < escaner->tam)
+    {
+        const char *inicio = escaner->datos + escaner->pos;
+        const char *fin = memchr(inicio, '\n', escaner->tam - escaner->pos);
+        if (fin == NULL)
+            fin = escaner->datos + escaner->tam;
+        escaner->pos = fin - escaner->datos + 1;
+        escaner->lineas++;
+
+        if (fin > inicio && fin[-1] == '\r')
+            fin--;
+        if (convertir_linea(escaner, inicio, fin, registro))
+            return 1;
+        escaner->descartadas++;
+    }
+    return 0;
+}
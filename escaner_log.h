@@ -0,0 +1,25 @@
+#ifndef ESCANER_LOG_H
+#define ESCANER_LOG_H
+
+#include <stddef.h>
+#include "txlog.h"
+
+// Escaner de logs de transacciones en texto (transacciones.log antiguos o la
+// salida de txlog-dump) con el formato:
+// [AAAA-MM-DD hh:mm:ss] Cuenta: N | Operación: X | Monto: F | Saldo final: F
+typedef struct
+{
+    const char *datos; // fichero mapeado
+    size_t tam;
+    size_t pos;        // inicio de la siguiente linea
+    long long lineas;
+    long long descartadas; // lineas que no tienen el formato
+    char hora[13];     // "AAAA-MM-DD hh" de la ultima linea convertida
+    long long marca_hora; // segundos desde epoch de esa hora
+} EscanerLog;
+
+int escaner_abrir(EscanerLog *escaner, const char *ruta);
+int escaner_siguiente(EscanerLog *escaner, RegistroTx *registro);
+void escaner_cerrar(EscanerLog *escaner);
+
+#endif
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include "escritura.h"
+#include "memoria.h"
+#include "persistencia.h"
+#include "wal.h"
+
+// Estado local del proceso sobre el buffer compartido
+static BufferEstructurado *buffer = NULL;
+static TablaCuentas *tabla_buffer = NULL;
+
+// Crea el buffer vacio (lo llama el banco al arrancar, antes que ningun usuario)
+// retorno de 0 si todo va bien, -1 en caso de error
+int buffer_crear(TablaCuentas *tabla)
+{
+    buffer = memoria_crear(NOMBRE_SHM_BUFFER, sizeof(BufferEstructurado));
+    if (buffer == NULL)
+        return -1;
+
+    buffer->cabeza_sucias = 0;
+    buffer->parar = 0;
+    buffer->marcadas = 0;
+    buffer->escritas = 0;
+    if (sem_init(&buffer->sem_lleno, 1, 0) == -1) // inicialmente vacio
+    {
+        perror("sem_init buffer");
+        return -1;
+    }
+
+    tabla_buffer = tabla;
+    return 0;
+}
+
+// Adjunta el buffer creado por el banco sin tocar su estado
+// retorno de 0 si todo va bien, -1 en caso de error
+int buffer_adjuntar(TablaCuentas *tabla)
+{
+    buffer = memoria_adjuntar(NOMBRE_SHM_BUFFER, sizeof(BufferEstructurado));
+    if (buffer == NULL)
+        return -1;
+
+    tabla_buffer = tabla;
+    return 0;
+}
+
+// Marca la ranura como pendiente de escribirse en disco
+// Nunca bloquea: si la cuenta ya estaba pendiente no se hace nada, el
+// volcado escribira su estado mas reciente
+void buffer_marcar(RanuraCuenta *ranura)
+{
+    __atomic_fetch_add(&buffer->marcadas, 1, __ATOMIC_RELAXED);
+
+    if (__atomic_exchange_n(&ranura->sucia, 1, __ATOMIC_ACQ_REL) == 1)
+        return;
+
+    // apilar la ranura en la lista de pendientes
+    int posicion = ranura - tabla_buffer->ranuras;
+    int cabeza = __atomic_load_n(&buffer->cabeza_sucias, __ATOMIC_RELAXED);
+    do
+    {
+        ranura->siguiente_sucia = cabeza;
+    } while (!__atomic_compare_exchange_n(&buffer->cabeza_sucias, &cabeza, posicion + 1, 0,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    // solo hace falta despertar al hilo de escritura si la pila estaba vacia
+    if (cabeza == 0)
+        sem_post(&buffer->sem_lleno);
+}
+
+// Saca todas las ranuras pendientes y escribe su estado actual en cuentas.dat
+// Las cuentas se copian con el seqlock y se escriben por lotes: un lote es una
+// sola pasada sobre el fichero mapeado y una sola sincronizacion
+// retorno del numero de cuentas escritas
+int buffer_volcar()
+{
+    int pendiente = __atomic_exchange_n(&buffer->cabeza_sucias, 0, __ATOMIC_ACQUIRE);
+    CuentaBancaria lote[LOTE_ESCRITURA];
+    int num_lote = 0;
+    int escritas = 0;
+
+    while (pendiente != 0)
+    {
+        int posicion = pendiente - 1;
+        RanuraCuenta *ranura = &tabla_buffer->ranuras[posicion];
+
+        // leer el enlace antes de quitar la marca, despues otro proceso puede volver a apilarla
+        // la copia se hace despues de quitar la marca: un cambio que no vuelva a
+        // apilar la ranura porque aun estaba marcada ya esta en la tabla
+        pendiente = ranura->siguiente_sucia;
+        __atomic_exchange_n(&ranura->sucia, 0, __ATOMIC_SEQ_CST);
+
+        tabla_leer_posicion(tabla_buffer, posicion, &lote[num_lote++]);
+
+        if (num_lote == LOTE_ESCRITURA || pendiente == 0)
+        {
+            if (persistencia_escribir_lote(lote, num_lote) == -1)
+                fprintf(stderr, "Error al escribir un lote de %d cuentas en disco\n", num_lote);
+            escritas += num_lote;
+            num_lote = 0;
+        }
+    }
+
+    __atomic_fetch_add(&buffer->escritas, escritas, __ATOMIC_RELAXED);
+    return escritas;
+}
+
+// Escribe de inmediato todo lo pendiente
+void buffer_vaciar()
+{
+    while (buffer_volcar() > 0)
+        ;
+}
+
+// Hilo del banco que se encarga de la escritura en cuentas.dat
+// Es el unico escritor del fichero, con independencia del numero de usuarios
+void *buffer_hilo_escritura(void *arg)
+{
+    (void)arg;
+    while (!__atomic_load_n(&buffer->parar, __ATOMIC_ACQUIRE))
+    {
+        sem_wait(&buffer->sem_lleno); // Espera hasta que haya cuentas pendientes
+
+        // los usuarios siguen marcando cuentas mientras se escribe el lote
+        buffer_volcar();
+
+        // con el WAL demasiado grande se escribe toda la tabla y se recorta
+        if (wal_punto_control(WAL, tabla_buffer) == -1)
+            fprintf(stderr, "Error en el punto de control del WAL\n");
+    }
+
+    // lo marcado entre el ultimo volcado y la parada
+    buffer_vaciar();
+    return NULL;
+}
+
+// Pide al hilo de escritura que vuelque lo pendiente y termine
+void buffer_detener()
+{
+    __atomic_store_n(&buffer->parar, 1, __ATOMIC_RELEASE);
+    sem_post(&buffer->sem_lleno);
+}
@@ -0,0 +1,35 @@
+#ifndef ESCRITURA_H
+#define ESCRITURA_H
+
+#include <semaphore.h>
+#include "tabla_cuentas.h"
+
+#define NOMBRE_SHM_BUFFER "/secure_bank_buffer" // Buffer de escritura diferida compartido
+#define LOTE_ESCRITURA 256                       // cuentas sucias que se vuelcan juntas en cuentas.dat
+
+// Buffer de escritura diferida de cuentas modificadas
+// No guarda copias de las cuentas: cada ranura de la tabla tiene una marca de
+// sucia y un enlace, y el buffer es la cabeza de una pila sin cerrojos con las
+// ranuras pendientes. Una cuenta modificada varias veces antes del volcado
+// aparece una sola vez y se escribe su ultimo estado.
+// Lo crea el banco, que tiene el unico hilo que escribe en cuentas.dat;
+// los procesos usuario solo marcan ranuras
+typedef struct {
+    int cabeza_sucias;      // posicion+1 de la ultima ranura marcada, 0 = no hay pendientes
+    sem_t sem_lleno;        // despierta al hilo de escritura cuando la pila deja de estar vacia
+    int parar;              // el banco pide al hilo de escritura que termine
+    unsigned long marcadas; // operaciones encoladas
+    unsigned long escritas; // cuentas escritas en disco
+} BufferEstructurado;
+
+int buffer_crear(TablaCuentas *tabla);
+int buffer_adjuntar(TablaCuentas *tabla);
+
+void buffer_marcar(RanuraCuenta *ranura);
+int buffer_volcar();
+void buffer_vaciar();
+
+void *buffer_hilo_escritura(void *arg);
+void buffer_detener();
+
+#endif
@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <signal.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include "eventos.h"
+#include "memoria.h"
+
+// Estado local del proceso sobre el anillo
+static AnilloEventos *anillo_eventos = NULL;
+
+static long futex(unsigned int *direccion, int operacion, unsigned int valor, const struct timespec *limite)
+{
+    return syscall(SYS_futex, direccion, operacion, valor, limite, NULL, 0);
+}
+
+// Crea el anillo vacio (lo llama el banco al arrancar)
+// retorno de 0 si todo va bien, -1 en caso de error
+int eventos_crear()
+{
+    anillo_eventos = memoria_crear(NOMBRE_SHM_EVENTOS, sizeof(AnilloEventos));
+    if (anillo_eventos == NULL)
+        return -1;
+
+    // el objeto se crea a cero: todas las secuencias vacias
+    anillo_eventos->generacion = ((unsigned long long)time(NULL) << 20) ^ (unsigned long long)getpid();
+    anillo_eventos->pos_escritura = 0;
+    anillo_eventos->aviso = 0;
+    anillo_eventos->esperando = 0;
+    return 0;
+}
+
+// Adjunta el anillo creado por el banco
+// retorno de 0 si todo va bien, -1 si no existe
+int eventos_adjuntar()
+{
+    anillo_eventos = memoria_adjuntar(NOMBRE_SHM_EVENTOS, sizeof(AnilloEventos));
+    return anillo_eventos == NULL ? -1 : 0;
+}
+
+// Publica un evento sin esperar nunca al consumidor
+void eventos_publicar(const RegistroTx *evento)
+{
+    if (anillo_eventos == NULL)
+        return;
+
+    unsigned long long pos = __atomic_fetch_add(&anillo_eventos->pos_escritura, 1, __ATOMIC_RELAXED);
+    CeldaEvento *celda = &anillo_eventos->celdas[pos & (EVENTOS_CAPACIDAD - 1)];
+
+    // firma del hueco: el lector puede comprobar si su productor sigue vivo
+    __atomic_store_n(&celda->productor, getpid(), __ATOMIC_RELAXED);
+    __atomic_store_n(&celda->reservada, pos + 1, __ATOMIC_RELEASE);
+
+    // secuencia a 0 mientras se copia: el lector no acepta una copia a medias
+    __atomic_store_n(&celda->secuencia, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    celda->evento = *evento;
+    __atomic_store_n(&celda->secuencia, pos + 1, __ATOMIC_RELEASE);
+
+    __atomic_fetch_add(&anillo_eventos->aviso, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&anillo_eventos->esperando, __ATOMIC_SEQ_CST))
+        futex(&anillo_eventos->aviso, FUTEX_WAKE, 1, NULL);
+}
+
+// El lector empieza por los eventos que se publiquen a partir de ahora
+void eventos_iniciar_lector(LectorEventos *lector)
+{
+    lector->generacion = anillo_eventos->generacion;
+    lector->leido = __atomic_load_n(&anillo_eventos->pos_escritura, __ATOMIC_ACQUIRE);
+    lector->perdidos = 0;
+    lector->perdidos_atasco = 0;
+    lector->atascado_en = 0;
+    lector->atascado_desde = 0;
+}
+
+// Continua la lectura en una posicion guardada (checkpoint del monitor)
+// Si los productores ya han dado la vuelta, eventos_leer cuenta los perdidos
+// retorno de 0 si la posicion es de este anillo, -1 si el banco lo ha
+// recreado (el lector empieza entonces por los eventos nuevos)
+int eventos_reanudar_lector(LectorEventos *lector, unsigned long long generacion, unsigned long long leido)
+{
+    eventos_iniciar_lector(lector);
+    if (generacion != lector->generacion || leido > lector->leido)
+        return -1;
+
+    lector->leido = leido;
+    return 0;
+}
+
+// Copia hasta max eventos nuevos en orden de publicacion
+// Si los productores han dado una vuelta completa al anillo desde la ultima
+// lectura, los eventos sobrescritos se cuentan en perdidos y se salta al
+// evento mas antiguo que sigue en el anillo
+// retorno del numero de eventos copiados
+int eventos_leer(LectorEventos *lector, RegistroTx *eventos, int max)
+{
+    int copiados = 0;
+
+    while (copiados < max)
+    {
+        unsigned long long escritura = __atomic_load_n(&anillo_eventos->pos_escritura, __ATOMIC_ACQUIRE);
+        if (lector->leido >= escritura)
+            break;
+
+        if (escritura - lector->leido > EVENTOS_CAPACIDAD)
+        {
+            unsigned long long primero = escritura - EVENTOS_CAPACIDAD;
+            lector->perdidos += primero - lector->leido;
+            lector->leido = primero;
+        }
+
+        CeldaEvento *celda = &anillo_eventos->celdas[lector->leido & (EVENTOS_CAPACIDAD - 1)];
+        unsigned long long esperada = lector->leido + 1;
+        unsigned long long antes = __atomic_load_n(&celda->secuencia, __ATOMIC_ACQUIRE);
+
+        if (antes > esperada)
+        {
+            // sobrescrito por una vuelta posterior mientras se leia
+            lector->perdidos++;
+            lector->leido++;
+            continue;
+        }
+        if (antes != esperada)
+            break; // reservado pero aun sin publicar
+
+        RegistroTx copia = celda->evento;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&celda->secuencia, __ATOMIC_RELAXED) != esperada)
+        {
+            lector->perdidos++;
+            lector->leido++;
+            continue;
+        }
+
+        eventos[copiados++] = copia;
+        lector->leido++;
+    }
+    return copiados;
+}
+
+static long long ahora_ms()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000LL + t.tv_nsec / 1000000;
+}
+
+// El evento reservado en la posicion leida ya no se va a publicar
+// Un productor lento o expropiado no se da por perdido: el evento tiene que
+// llevar EVENTOS_ATASCO_MS sin publicarse y su proceso haber muerto (o no
+// haber llegado a firmar el hueco). A un productor vivo se le espera hasta
+// EVENTOS_ATASCO_MAXIMO_MS, por si esta parado
+static int productor_perdido(LectorEventos *lector, CeldaEvento *celda)
+{
+    long long ahora = ahora_ms();
+    if (lector->atascado_en != lector->leido + 1)
+    {
+        lector->atascado_en = lector->leido + 1;
+        lector->atascado_desde = ahora;
+        return 0;
+    }
+    if (ahora - lector->atascado_desde < EVENTOS_ATASCO_MS)
+        return 0;
+    if (ahora - lector->atascado_desde >= EVENTOS_ATASCO_MAXIMO_MS)
+        return 1;
+
+    if (__atomic_load_n(&celda->reservada, __ATOMIC_ACQUIRE) != lector->leido + 1)
+        return 1; // murio entre reservar la posicion y firmarla
+    pid_t productor = __atomic_load_n(&celda->productor, __ATOMIC_RELAXED);
+    return kill(productor, 0) == -1 && errno == ESRCH;
+}
+
+// Duerme hasta que se publique un evento o pasen EVENTOS_ESPERA_MS
+// Si el evento esperado sigue reservado pero sin publicar y su productor
+// ya no lo va a publicar, se salta y se cuenta en perdidos_atasco
+void eventos_esperar(LectorEventos *lector)
+{
+    unsigned int aviso = __atomic_load_n(&anillo_eventos->aviso, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&anillo_eventos->esperando, 1, __ATOMIC_SEQ_CST);
+
+    unsigned long long escritura = __atomic_load_n(&anillo_eventos->pos_escritura, __ATOMIC_ACQUIRE);
+    CeldaEvento *celda = &anillo_eventos->celdas[lector->leido & (EVENTOS_CAPACIDAD - 1)];
+    int atascado = lector->leido < escritura;
+
+    if (!atascado || __atomic_load_n(&celda->secuencia, __ATOMIC_ACQUIRE) != lector->leido + 1)
+    {
+        struct timespec limite = {0, EVENTOS_ESPERA_MS * 1000000L};
+        futex(&anillo_eventos->aviso, FUTEX_WAIT, aviso, &limite);
+
+        // con otros productores publicando el futex despierta antes de la
+        // espera completa: el atasco se mide en tiempo, no en esperas
+        if (atascado && __atomic_load_n(&celda->secuencia, __ATOMIC_ACQUIRE) != lector->leido + 1 &&
+            productor_perdido(lector, celda))
+        {
+            lector->perdidos_atasco++;
+            lector->leido++;
+        }
+    }
+
+    __atomic_store_n(&anillo_eventos->esperando, 0, __ATOMIC_RELAXED);
+}
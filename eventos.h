@@ -0,0 +1,59 @@
+#ifndef EVENTOS_H
+#define EVENTOS_H
+
+#include <sys/types.h>
+#include "txlog.h"
+
+#define NOMBRE_SHM_EVENTOS "/secure_bank_eventos" // Flujo de eventos de usuario a monitor
+#define EVENTOS_CAPACIDAD (1 << 16)               // eventos del anillo (potencia de 2)
+#define EVENTOS_ESPERA_MS 100                     // espera maxima del consumidor en el futex
+#define EVENTOS_ATASCO_MS 1000                    // espera a un evento sin publicar antes de saltarlo
+#define EVENTOS_ATASCO_MAXIMO_MS 10000            // espera a un productor vivo antes de saltarlo
+
+// Hueco del anillo: secuencia = posicion+1 cuando el evento esta publicado,
+// 0 mientras un productor lo esta escribiendo. reservada = posicion+1 en
+// cuanto el productor firma el hueco con su pid, para saber si sigue vivo
+typedef struct
+{
+    unsigned long long secuencia;
+    unsigned long long reservada;
+    pid_t productor;
+    RegistroTx evento;
+} CeldaEvento;
+
+// Anillo de eventos de operaciones en memoria compartida
+// Los productores (usuarios) nunca esperan: reservan una posicion con un
+// contador atomico y sobrescriben el hueco aunque el monitor no lo haya leido.
+// El monitor detecta por la secuencia los eventos que se ha perdido (desborde)
+// y duerme en un futex cuando no hay nada nuevo
+typedef struct
+{
+    unsigned long long generacion;    // distinta en cada arranque del banco
+    unsigned long long pos_escritura; // siguiente posicion que reservan los productores
+    unsigned int aviso;               // palabra del futex, cambia con cada publicacion
+    int esperando;                    // el consumidor duerme en el futex
+    CeldaEvento celdas[EVENTOS_CAPACIDAD];
+} AnilloEventos;
+
+// Posicion de lectura del consumidor
+typedef struct
+{
+    unsigned long long generacion; // anillo al que se refiere la posicion
+    unsigned long long leido;   // siguiente posicion a leer
+    unsigned long long perdidos; // eventos sobrescritos antes de leerlos
+    unsigned long long perdidos_atasco; // eventos saltados porque su productor no los publico
+    unsigned long long atascado_en;     // posicion+1 que espera a publicarse, 0 si ninguna
+    long long atascado_desde;           // ms (CLOCK_MONOTONIC) desde que espera
+} LectorEventos;
+
+int eventos_crear();
+int eventos_adjuntar();
+
+void eventos_publicar(const RegistroTx *evento);
+
+void eventos_iniciar_lector(LectorEventos *lector);
+int eventos_reanudar_lector(LectorEventos *lector, unsigned long long generacion, unsigned long long leido);
+int eventos_leer(LectorEventos *lector, RegistroTx *eventos, int max);
+void eventos_esperar(LectorEventos *lector);
+
+#endif
@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "grafo.h"
+#include "indice_cuentas.h"
+
+// Grafo de transferencias recientes para detectar dispersion, concentracion
+// y ciclos a medida que llegan las transferencias
+// Cada cuenta guarda un numero fijo de aristas por sentido en la posicion que
+// le da indice_cuentas, asi procesar una transferencia cuesta como mucho
+// ARISTAS_NODO busquedas de ARISTAS_NODO aristas al buscar ciclos,
+// independiente del tamanio del grafo. Las cuentas sin actividad durante una
+// ventana caducan y su entrada se libera
+
+// Estado local del monitor
+static IndiceCuentas indice;
+static NodoGrafo *nodos = NULL; // por posicion del indice
+static int ventana_grafo = 300;
+static int umbral_dispersion_grafo = 5;
+static int umbral_concentracion_grafo = 5;
+
+static int reciente(long long marca_arista, long long marca)
+{
+    return marca - marca_arista <= ventana_grafo;
+}
+
+static int caducado(int posicion, long long marca)
+{
+    return !reciente(nodos[posicion].ultima_actividad, marca);
+}
+
+static void liberar(int posicion)
+{
+    nodos[posicion].ocupado = 0;
+}
+
+// Reserva la tabla de cuentas del grafo
+// ventana en segundos, umbrales en cuentas distintas (como mucho ARISTAS_NODO)
+// retorno de 0 si todo va bien, -1 en caso de error
+int grafo_iniciar(int ventana, int umbral_dispersion, int umbral_concentracion)
+{
+    nodos = calloc(MAX_NODOS_GRAFO, sizeof(NodoGrafo));
+    if (nodos == NULL)
+    {
+        perror("calloc grafo de transferencias");
+        return -1;
+    }
+    if (indice_iniciar(&indice, MAX_NODOS_GRAFO, caducado, liberar) == -1)
+        return -1;
+
+    if (umbral_dispersion > ARISTAS_NODO)
+        umbral_dispersion = ARISTAS_NODO;
+    if (umbral_concentracion > ARISTAS_NODO)
+        umbral_concentracion = ARISTAS_NODO;
+    ventana_grafo = ventana;
+    umbral_dispersion_grafo = umbral_dispersion;
+    umbral_concentracion_grafo = umbral_concentracion;
+    return 0;
+}
+
+// Cuenta del grafo; con crear se da de alta si no esta
+// retorno de NULL si no esta (sin crear) o si la tabla esta llena
+static NodoGrafo *nodo_de(int numero_cuenta, long long marca, int crear)
+{
+    if (!crear)
+    {
+        int posicion = indice_buscar(&indice, numero_cuenta);
+        return posicion == -1 ? NULL : &nodos[posicion];
+    }
+
+    int nueva;
+    int posicion = indice_alta(&indice, numero_cuenta, marca, &nueva);
+    if (posicion == -1)
+        return NULL;
+    NodoGrafo *n = &nodos[posicion];
+    if (nueva)
+    {
+        NodoGrafo vacio = {0};
+        *n = vacio;
+        n->ocupado = 1;
+        n->numero_cuenta = numero_cuenta;
+        n->ultima_actividad = marca;
+    }
+    return n;
+}
+
+// Anota la arista hacia cuenta: actualiza la existente o sustituye la mas antigua
+// retorno del numero de aristas dentro de la ventana tras anotarla
+static int anotar_arista(AristaGrafo *aristas, int cuenta, long long marca)
+{
+    AristaGrafo *hueco = &aristas[0];
+    for (int i = 0; i < ARISTAS_NODO; i++)
+    {
+        if (aristas[i].cuenta == cuenta)
+        {
+            hueco = &aristas[i];
+            break;
+        }
+        if (aristas[i].marca < hueco->marca)
+            hueco = &aristas[i];
+    }
+    hueco->cuenta = cuenta;
+    if (marca > hueco->marca)
+        hueco->marca = marca;
+
+    int recientes = 0;
+    for (int i = 0; i < ARISTAS_NODO; i++)
+    {
+        if (aristas[i].cuenta != 0 && reciente(aristas[i].marca, marca))
+            recientes++;
+    }
+    return recientes;
+}
+
+static int tiene_arista(const NodoGrafo *n, int cuenta, long long marca)
+{
+    for (int i = 0; i < ARISTAS_NODO; i++)
+    {
+        if (n->salientes[i].cuenta == cuenta && reciente(n->salientes[i].marca, marca))
+            return 1;
+    }
+    return 0;
+}
+
+// Busca un ciclo que cierre la nueva arista origen->destino con aristas
+// recientes: destino->origen, o destino->intermedia->origen
+// retorno de la cuenta intermedia, 0 si el ciclo es de dos, -1 si no hay ciclo
+static int buscar_ciclo(const NodoGrafo *destino, int origen, long long marca)
+{
+    if (tiene_arista(destino, origen, marca))
+        return 0;
+
+    for (int i = 0; i < ARISTAS_NODO; i++)
+    {
+        const AristaGrafo *a = &destino->salientes[i];
+        if (a->cuenta == 0 || a->cuenta == origen || !reciente(a->marca, marca))
+            continue;
+        const NodoGrafo *intermedia = nodo_de(a->cuenta, marca, 0);
+        if (intermedia != NULL && tiene_arista(intermedia, origen, marca))
+            return a->cuenta;
+    }
+    return -1;
+}
+
+// Aniade al grafo la transferencia y comprueba dispersion, concentracion y ciclos
+// Solo se usan las transferencias enviadas, la recibida es la misma arista
+// Una cuenta no repite la misma alerta hasta que pasa una ventana
+// retorno del numero de alertas generadas en alertas[]
+int grafo_procesar(const RegistroTx *tx, AlertaGrafo *alertas)
+{
+    if (tx->operacion != TX_TRANSFERENCIA_ENVIADA || tx->contraparte == 0 ||
+        tx->contraparte == tx->numero_cuenta)
+        return 0;
+
+    // el origen se marca activo antes de buscar el destino para que no se
+    // reutilice su entrada como caducada
+    NodoGrafo *origen = nodo_de(tx->numero_cuenta, tx->marca, 1);
+    if (origen == NULL)
+        return 0;
+    if (tx->marca > origen->ultima_actividad)
+        origen->ultima_actividad = tx->marca;
+    NodoGrafo *destino = nodo_de(tx->contraparte, tx->marca, 1);
+    if (destino == NULL)
+        return 0;
+    if (tx->marca > destino->ultima_actividad)
+        destino->ultima_actividad = tx->marca;
+
+    int enviadas = anotar_arista(origen->salientes, tx->contraparte, tx->marca);
+    int recibidas = anotar_arista(destino->entrantes, tx->numero_cuenta, tx->marca);
+
+    int num_alertas = 0;
+    if (enviadas >= umbral_dispersion_grafo && tx->marca >= origen->alerta_dispersion)
+    {
+        alertas[num_alertas++] = (AlertaGrafo){GRAFO_DISPERSION, tx->numero_cuenta, enviadas, {0, 0, 0}};
+        origen->alerta_dispersion = tx->marca + ventana_grafo;
+    }
+    if (recibidas >= umbral_concentracion_grafo && tx->marca >= destino->alerta_concentracion)
+    {
+        alertas[num_alertas++] = (AlertaGrafo){GRAFO_CONCENTRACION, tx->contraparte, recibidas, {0, 0, 0}};
+        destino->alerta_concentracion = tx->marca + ventana_grafo;
+    }
+    if (tx->marca >= origen->alerta_ciclo)
+    {
+        int intermedia = buscar_ciclo(destino, tx->numero_cuenta, tx->marca);
+        if (intermedia != -1)
+        {
+            alertas[num_alertas++] = (AlertaGrafo){GRAFO_CICLO, tx->numero_cuenta, 0,
+                                                   {tx->numero_cuenta, tx->contraparte, intermedia}};
+            origen->alerta_ciclo = tx->marca + ventana_grafo;
+        }
+    }
+    return num_alertas;
+}
+
+// Escribe las cuentas del grafo con actividad dentro de la ventana
+// retorno de 0 si todo va bien, -1 en caso de error
+int grafo_guardar(FILE *archivo, long long marca)
+{
+    int activos = 0;
+    for (int i = 0; i < MAX_NODOS_GRAFO; i++)
+    {
+        if (nodos[i].ocupado && reciente(nodos[i].ultima_actividad, marca))
+            activos++;
+    }
+    if (fwrite(&activos, sizeof(int), 1, archivo) != 1)
+        return -1;
+
+    for (int i = 0; i < MAX_NODOS_GRAFO; i++)
+    {
+        if (nodos[i].ocupado && reciente(nodos[i].ultima_actividad, marca) &&
+            fwrite(&nodos[i], sizeof(NodoGrafo), 1, archivo) != 1)
+            return -1;
+    }
+    return 0;
+}
+
+// Recupera las cuentas guardadas por grafo_guardar
+// retorno de 0 si todo va bien, -1 si el fichero esta incompleto
+int grafo_cargar(FILE *archivo, long long marca)
+{
+    int activos;
+    if (fread(&activos, sizeof(int), 1, archivo) != 1)
+        return -1;
+
+    for (int i = 0; i < activos; i++)
+    {
+        NodoGrafo guardado;
+        if (fread(&guardado, sizeof(NodoGrafo), 1, archivo) != 1)
+            return -1;
+        NodoGrafo *n = nodo_de(guardado.numero_cuenta, marca, 1);
+        if (n != NULL)
+            *n = guardado;
+    }
+    return 0;
+}
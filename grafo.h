@@ -0,0 +1,52 @@
+#ifndef GRAFO_H
+#define GRAFO_H
+
+#include <stdio.h>
+#include "txlog.h"
+
+#define MAX_NODOS_GRAFO (1 << 16) // cuentas con aristas recientes a la vez (potencia de 2)
+#define ARISTAS_NODO 8            // aristas recientes que se guardan por sentido y cuenta
+#define MAX_ALERTAS_GRAFO 3       // alertas que puede generar una transferencia
+
+// Tipos de alerta del grafo
+#define GRAFO_DISPERSION 1    // una cuenta envia a muchas cuentas distintas (fan-out)
+#define GRAFO_CONCENTRACION 2 // una cuenta recibe de muchas cuentas distintas (fan-in)
+#define GRAFO_CICLO 3         // el dinero vuelve al origen (A->B->A o A->B->C->A)
+
+// Arista reciente hacia (o desde) otra cuenta; se actualiza en su sitio si
+// la misma pareja vuelve a transferir
+typedef struct
+{
+    int cuenta;       // 0 = hueco libre
+    long long marca;  // ultima transferencia entre la pareja
+} AristaGrafo;
+
+// Cuenta del grafo con sus ultimas ARISTAS_NODO aristas en cada sentido
+// Las aristas mas antiguas que la ventana no cuentan (decaimiento) y cuando
+// no hay hueco se sustituye la mas antigua, asi el coste por cuenta es fijo
+typedef struct
+{
+    int ocupado;
+    int numero_cuenta;
+    long long ultima_actividad;
+    long long alerta_dispersion; // marca hasta la que no se repite cada alerta
+    long long alerta_concentracion;
+    long long alerta_ciclo;
+    AristaGrafo salientes[ARISTAS_NODO];
+    AristaGrafo entrantes[ARISTAS_NODO];
+} NodoGrafo;
+
+typedef struct
+{
+    int tipo;          // GRAFO_*
+    int numero_cuenta;
+    int cuentas;       // cuentas distintas en la ventana (dispersion y concentracion)
+    int ciclo[3];      // cuentas del ciclo en orden, la ultima es 0 en un ciclo de dos
+} AlertaGrafo;
+
+int grafo_iniciar(int ventana, int umbral_dispersion, int umbral_concentracion);
+int grafo_procesar(const RegistroTx *tx, AlertaGrafo *alertas);
+int grafo_guardar(FILE *archivo, long long marca);
+int grafo_cargar(FILE *archivo, long long marca);
+
+#endif
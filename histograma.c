@@ -0,0 +1,89 @@
+#include <string.h>
+#include "histograma.h"
+
+// Los valores menores que HISTOGRAMA_SUBCUBETAS tienen cubeta propia; el resto
+// se reparte en HISTOGRAMA_SUBCUBETAS cubetas por cada potencia de dos
+static int cubeta(unsigned long long valor)
+{
+    if (valor < HISTOGRAMA_SUBCUBETAS)
+        return (int)valor;
+    int bit = 63 - __builtin_clzll(valor);
+    int desplazamiento = bit - HISTOGRAMA_BITS_SUBCUBETA;
+    return (desplazamiento + 1) * HISTOGRAMA_SUBCUBETAS +
+           (int)((valor >> desplazamiento) - HISTOGRAMA_SUBCUBETAS);
+}
+
+// Valor representativo de una cubeta: el punto medio de su intervalo
+static unsigned long long valor_cubeta(int indice)
+{
+    if (indice < HISTOGRAMA_SUBCUBETAS)
+        return indice;
+    int desplazamiento = indice / HISTOGRAMA_SUBCUBETAS - 1;
+    unsigned long long inicio = (unsigned long long)(HISTOGRAMA_SUBCUBETAS + indice % HISTOGRAMA_SUBCUBETAS)
+                                << desplazamiento;
+    return inicio + ((1ULL << desplazamiento) >> 1);
+}
+
+void histograma_iniciar(Histograma *histograma)
+{
+    memset(histograma, 0, sizeof(*histograma));
+}
+
+void histograma_anotar(Histograma *histograma, unsigned long long valor)
+{
+    histograma->cuentas[cubeta(valor)]++;
+    if (histograma->total == 0 || valor < histograma->minimo)
+        histograma->minimo = valor;
+    if (valor > histograma->maximo)
+        histograma->maximo = valor;
+    histograma->total++;
+    histograma->suma += valor;
+}
+
+// Acumula un histograma en otro, p. ej. los de cada hilo en uno global
+void histograma_sumar(Histograma *destino, const Histograma *origen)
+{
+    if (origen->total == 0)
+        return;
+    for (int i = 0; i < HISTOGRAMA_CUBETAS; i++)
+        destino->cuentas[i] += origen->cuentas[i];
+    if (destino->total == 0 || origen->minimo < destino->minimo)
+        destino->minimo = origen->minimo;
+    if (origen->maximo > destino->maximo)
+        destino->maximo = origen->maximo;
+    destino->total += origen->total;
+    destino->suma += origen->suma;
+}
+
+// Valor por debajo del cual queda el percentil indicado (0-100)
+// retorno de 0 si el histograma esta vacio
+unsigned long long histograma_percentil(const Histograma *histograma, double percentil)
+{
+    if (histograma->total == 0)
+        return 0;
+    unsigned long long objetivo = (unsigned long long)(percentil / 100.0 * histograma->total + 0.5);
+    if (objetivo < 1)
+        objetivo = 1;
+
+    unsigned long long acumulado = 0;
+    for (int i = 0; i < HISTOGRAMA_CUBETAS; i++)
+    {
+        acumulado += histograma->cuentas[i];
+        if (acumulado >= objetivo)
+        {
+            unsigned long long valor = valor_cubeta(i);
+            // el extremo de la cubeta nunca pasa de lo medido
+            if (valor > histograma->maximo)
+                valor = histograma->maximo;
+            if (valor < histograma->minimo)
+                valor = histograma->minimo;
+            return valor;
+        }
+    }
+    return histograma->maximo;
+}
+
+double histograma_media(const Histograma *histograma)
+{
+    return histograma->total ? histograma->suma / histograma->total : 0.0;
+}
@@ -0,0 +1,25 @@
+#ifndef HISTOGRAMA_H
+#define HISTOGRAMA_H
+
+#define HISTOGRAMA_BITS_SUBCUBETA 4 // 16 cubetas por potencia de dos, error < 6.25%
+#define HISTOGRAMA_SUBCUBETAS (1 << HISTOGRAMA_BITS_SUBCUBETA)
+#define HISTOGRAMA_CUBETAS (64 * HISTOGRAMA_SUBCUBETAS)
+
+// Histograma de latencias con cubetas logaritmicas, como los HDR:
+// tamanio fijo, anotar es O(1) y los percentiles salen sin guardar las muestras
+typedef struct
+{
+    unsigned long long cuentas[HISTOGRAMA_CUBETAS];
+    unsigned long long total;
+    unsigned long long minimo;
+    unsigned long long maximo;
+    double suma;
+} Histograma;
+
+void histograma_iniciar(Histograma *histograma);
+void histograma_anotar(Histograma *histograma, unsigned long long valor);
+void histograma_sumar(Histograma *destino, const Histograma *origen);
+unsigned long long histograma_percentil(const Histograma *histograma, double percentil);
+double histograma_media(const Histograma *histograma);
+
+#endif
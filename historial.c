@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "historial.h"
+
+// Almacen de historial por cuenta en segmentos de tamanio fijo
+// Un unico escritor (el hilo de logs del banco) aniade movimientos al final
+// del segmento actual; cada movimiento apunta al anterior de su cuenta y el
+// indice guarda el ultimo, asi que "ultimos N" lee N movimientos. El salto de
+// cada movimiento permite llegar a una fecha sin recorrer todos los posteriores.
+// Todas las cuentas comparten los segmentos: no hay un fichero por cuenta
+
+// Estado local del proceso sobre el historial
+static char dir_historial[100];
+static IndiceHistorial *indice = NULL;
+static int es_escritor = 0;
+static pthread_mutex_t mutex_lectura = PTHREAD_MUTEX_INITIALIZER;
+static int fd_segmento = -1;      // ultimo segmento leido
+static long long num_segmento = -1;
+static int fd_escritura = -1;     // segmento donde escribe el escritor
+static long long segmento_escritura = -1;
+
+// Lote del escritor
+static MovimientoHistorial lote[LOTE_HISTORIAL];
+static int num_lote = 0;
+static long long inicio_lote = 0; // posicion del primer movimiento del lote
+static int tocadas[LOTE_HISTORIAL]; // entradas del indice que cambian con el lote
+static int num_tocadas = 0;
+
+static void ruta_segmento(long long segmento, char *ruta, size_t tam)
+{
+    snprintf(ruta, tam, "%s/segmento_%06lld.dat", dir_historial, segmento);
+}
+
+// Abre un segmento para leer, reutilizando el ultimo abierto
+static int abrir_segmento(long long segmento)
+{
+    if (segmento == num_segmento)
+        return fd_segmento;
+
+    if (fd_segmento != -1)
+        close(fd_segmento);
+
+    char ruta[150];
+    ruta_segmento(segmento, ruta, sizeof(ruta));
+    fd_segmento = open(ruta, O_RDONLY);
+    num_segmento = fd_segmento == -1 ? -1 : segmento;
+    return fd_segmento;
+}
+
+// Segmento en el que escribe el escritor, se crea al llegar a el
+static int segmento_escritor(long long segmento)
+{
+    if (segmento == segmento_escritura)
+        return fd_escritura;
+
+    if (fd_escritura != -1)
+        close(fd_escritura);
+
+    char ruta[150];
+    ruta_segmento(segmento, ruta, sizeof(ruta));
+    fd_escritura = open(ruta, O_WRONLY | O_CREAT, 0644);
+    segmento_escritura = fd_escritura == -1 ? -1 : segmento;
+    if (fd_escritura == -1)
+        perror("Error al abrir el segmento del historial");
+    return fd_escritura;
+}
+
+// Lee un movimiento por su posicion+1
+// Solo el escritor puede tener movimientos en el lote sin escribir
+static int leer_movimiento(long long posicion, MovimientoHistorial *movimiento)
+{
+    long long p = posicion - 1;
+    if (es_escritor && p >= inicio_lote && p < inicio_lote + num_lote)
+    {
+        *movimiento = lote[p - inicio_lote];
+        return 0;
+    }
+
+    int fd = abrir_segmento(p / REGISTROS_SEGMENTO);
+    if (fd == -1)
+        return -1;
+    off_t desplazamiento = (off_t)(p % REGISTROS_SEGMENTO) * sizeof(MovimientoHistorial);
+    if (pread(fd, movimiento, sizeof(MovimientoHistorial), desplazamiento) != sizeof(MovimientoHistorial))
+        return -1;
+    return 0;
+}
+
+// Abre el historial, el escritor lo crea si no existe
+// retorno de 0 si todo va bien, -1 en caso de error
+int historial_abrir(const char *dir, int escritor)
+{
+    snprintf(dir_historial, sizeof(dir_historial), "%s", dir);
+    es_escritor = escritor;
+
+    if (escritor && mkdir(dir, 0700) == -1 && errno != EEXIST)
+    {
+        perror("Error al crear el directorio del historial");
+        return -1;
+    }
+
+    char ruta[150];
+    snprintf(ruta, sizeof(ruta), "%s/indice.dat", dir);
+    int fd = open(ruta, escritor ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (fd == -1)
+    {
+        perror("Error al abrir el indice del historial");
+        return -1;
+    }
+
+    // el fichero es disperso, solo ocupan disco las paginas con cuentas
+    if (escritor && ftruncate(fd, sizeof(IndiceHistorial)) == -1)
+    {
+        perror("ftruncate indice del historial");
+        close(fd);
+        return -1;
+    }
+
+    void *mapa = mmap(NULL, sizeof(IndiceHistorial), escritor ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapa == MAP_FAILED)
+    {
+        perror("mmap indice del historial");
+        return -1;
+    }
+    indice = mapa;
+
+    // lo anotado por un escritor anterior que no llego a publicarse se descarta
+    if (escritor)
+    {
+        inicio_lote = indice->siguiente;
+        for (int i = 0; i < TAM_INDICE_HISTORIAL; i++)
+        {
+            EntradaHistorial *e = &indice->entradas[i];
+            if (!e->ocupada || e->cabeza_escritor == e->cabeza)
+                continue;
+
+            MovimientoHistorial ultimo;
+            e->cabeza_escritor = e->cabeza;
+            e->num_movimientos = 0;
+            e->ultima_marca = 0;
+            if (e->cabeza != 0 && leer_movimiento(e->cabeza, &ultimo) == 0)
+            {
+                e->num_movimientos = ultimo.ordinal;
+                e->ultima_marca = ultimo.tx.marca;
+            }
+        }
+    }
+    return 0;
+}
+
+void historial_cerrar()
+{
+    if (indice == NULL)
+        return;
+    if (es_escritor)
+        historial_volcar();
+    munmap(indice, sizeof(IndiceHistorial));
+    indice = NULL;
+    if (fd_segmento != -1)
+        close(fd_segmento);
+    if (fd_escritura != -1)
+        close(fd_escritura);
+    fd_segmento = -1;
+    num_segmento = -1;
+    fd_escritura = -1;
+    segmento_escritura = -1;
+}
+
+// Hueco del indice de la cuenta, o el libre donde iria si crear es 1
+// retorno de -1 si no esta (o el indice esta lleno)
+static int buscar_entrada(int numero_cuenta, int crear)
+{
+    unsigned int h = ((unsigned int)numero_cuenta * 2654435761u) & (TAM_INDICE_HISTORIAL - 1);
+
+    for (int i = 0; i < TAM_INDICE_HISTORIAL; i++)
+    {
+        EntradaHistorial *e = &indice->entradas[h];
+        if (!__atomic_load_n(&e->ocupada, __ATOMIC_ACQUIRE))
+        {
+            if (!crear)
+                return -1;
+            e->numero_cuenta = numero_cuenta;
+            e->num_movimientos = 0;
+            e->ultima_marca = 0;
+            e->cabeza = 0;
+            e->cabeza_escritor = 0;
+            __atomic_store_n(&e->ocupada, 1, __ATOMIC_RELEASE);
+            return h;
+        }
+        if (e->numero_cuenta == numero_cuenta)
+            return h;
+        h = (h + 1) & (TAM_INDICE_HISTORIAL - 1);
+    }
+    return -1;
+}
+
+// Escribe el lote en su segmento y publica las nuevas cabezas del indice
+void historial_volcar()
+{
+    if (num_lote == 0)
+        return;
+
+    int fd = segmento_escritor(inicio_lote / REGISTROS_SEGMENTO);
+    off_t desplazamiento = (off_t)(inicio_lote % REGISTROS_SEGMENTO) * sizeof(MovimientoHistorial);
+    size_t tam = num_lote * sizeof(MovimientoHistorial);
+    if (fd == -1 || pwrite(fd, lote, tam, desplazamiento) != (ssize_t)tam)
+    {
+        // se publica igualmente: los lectores se detienen al no poder leer el hueco
+        perror("Error al escribir el historial");
+    }
+
+    // los lectores ven las cabezas nuevas solo cuando los movimientos estan escritos
+    for (int i = 0; i < num_tocadas; i++)
+    {
+        EntradaHistorial *e = &indice->entradas[tocadas[i]];
+        __atomic_store_n(&e->cabeza, e->cabeza_escritor, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&indice->siguiente, inicio_lote + num_lote, __ATOMIC_RELEASE);
+
+    inicio_lote += num_lote;
+    num_lote = 0;
+    num_tocadas = 0;
+}
+
+// Aniade una transaccion al historial de su cuenta (solo el escritor)
+void historial_anotar(const RegistroTx *tx)
+{
+    if (indice == NULL || !es_escritor)
+        return;
+
+    // un lote no cruza segmentos
+    if (num_lote == LOTE_HISTORIAL || (num_lote > 0 && (inicio_lote + num_lote) % REGISTROS_SEGMENTO == 0))
+        historial_volcar();
+
+    int h = buscar_entrada(tx->numero_cuenta, 1);
+    if (h == -1)
+    {
+        fprintf(stderr, "Indice del historial lleno, cuenta %d sin historial\n", tx->numero_cuenta);
+        return;
+    }
+    EntradaHistorial *e = &indice->entradas[h];
+
+    MovimientoHistorial *m = &lote[num_lote];
+    m->tx = *tx;
+    // las busquedas por fecha necesitan fechas crecientes dentro de la cuenta;
+    // dos procesos pueden anotar la misma cuenta con un segundo de desorden
+    if (m->tx.marca < e->ultima_marca)
+        m->tx.marca = e->ultima_marca;
+    e->ultima_marca = m->tx.marca;
+    m->anterior = e->cabeza_escritor;
+    m->ordinal = e->num_movimientos + 1;
+    m->salto = 0;
+
+    // el salto apunta al movimiento con ordinal (ordinal & (ordinal-1)): se
+    // sigue la cadena de saltos desde el anterior hasta llegar a ese ordinal
+    int objetivo = m->ordinal & (m->ordinal - 1);
+    if (objetivo > 0)
+    {
+        MovimientoHistorial previo;
+        long long posicion = m->anterior;
+        while (posicion != 0 && leer_movimiento(posicion, &previo) == 0 && previo.ordinal > objetivo)
+        {
+            long long siguiente = previo.anterior;
+            if (previo.salto != 0 && (previo.ordinal & (previo.ordinal - 1)) >= objetivo)
+                siguiente = previo.salto;
+            posicion = siguiente;
+        }
+        m->salto = posicion;
+    }
+
+    if (e->cabeza_escritor == e->cabeza)
+        tocadas[num_tocadas++] = h;
+    e->cabeza_escritor = inicio_lote + num_lote + 1;
+    e->num_movimientos++;
+    num_lote++;
+}
+
+// Copia los ultimos n movimientos de la cuenta, del mas reciente al mas antiguo
+// retorno del numero de movimientos copiados, -1 si el historial no esta abierto
+int historial_ultimos(int numero_cuenta, int n, MovimientoHistorial *salida)
+{
+    if (indice == NULL)
+        return -1;
+
+    pthread_mutex_lock(&mutex_lectura);
+    int h = buscar_entrada(numero_cuenta, 0);
+    long long posicion = h == -1 ? 0 : __atomic_load_n(&indice->entradas[h].cabeza, __ATOMIC_ACQUIRE);
+    int copiados = 0;
+
+    while (posicion != 0 && copiados < n && leer_movimiento(posicion, &salida[copiados]) == 0)
+    {
+        posicion = salida[copiados].anterior;
+        copiados++;
+    }
+    pthread_mutex_unlock(&mutex_lectura);
+    return copiados;
+}
+
+// Copia los movimientos de la cuenta con fecha en [desde, hasta], del mas reciente al mas antiguo
+// Los movimientos posteriores a hasta se saltan con los enlaces de salto
+// retorno del numero de movimientos copiados, -1 si el historial no esta abierto
+int historial_entre(int numero_cuenta, time_t desde, time_t hasta, MovimientoHistorial *salida, int max)
+{
+    if (indice == NULL)
+        return -1;
+
+    pthread_mutex_lock(&mutex_lectura);
+    int h = buscar_entrada(numero_cuenta, 0);
+    long long posicion = h == -1 ? 0 : __atomic_load_n(&indice->entradas[h].cabeza, __ATOMIC_ACQUIRE);
+    MovimientoHistorial actual, destino;
+    int copiados = 0;
+
+    // buscar el movimiento mas reciente con fecha <= hasta
+    while (posicion != 0 && leer_movimiento(posicion, &actual) == 0 && actual.tx.marca > hasta)
+    {
+        // las fechas crecen con el ordinal: si el destino del salto sigue siendo
+        // posterior a hasta, todos los intermedios tambien lo son
+        if (actual.salto != 0 && leer_movimiento(actual.salto, &destino) == 0 && destino.tx.marca > hasta)
+            posicion = actual.salto;
+        else
+            posicion = actual.anterior;
+    }
+
+    while (posicion != 0 && copiados < max && leer_movimiento(posicion, &salida[copiados]) == 0)
+    {
+        if (salida[copiados].tx.marca < desde)
+            break;
+        posicion = salida[copiados].anterior;
+        copiados++;
+    }
+    pthread_mutex_unlock(&mutex_lectura);
+    return copiados;
+}
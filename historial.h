@@ -0,0 +1,50 @@
+#ifndef HISTORIAL_H
+#define HISTORIAL_H
+
+#include <time.h>
+#include "txlog.h"
+
+#define DIR_HISTORIAL "transacciones"          // Directorio del historial por cuenta
+#define REGISTROS_SEGMENTO (1 << 16)           // movimientos por fichero de segmento
+#define TAM_INDICE_HISTORIAL (1 << 20)         // huecos del indice de cuentas (potencia de 2)
+#define LOTE_HISTORIAL 1024                    // movimientos que se escriben juntos
+
+// Movimiento del historial: la transaccion y los enlaces con los movimientos
+// anteriores de la misma cuenta. Las posiciones son globales (segmento y
+// desplazamiento) y se guardan como posicion+1, 0 indica que no hay
+typedef struct
+{
+    RegistroTx tx;
+    long long anterior; // movimiento anterior de la cuenta
+    long long salto;    // movimiento de ordinal (ordinal & (ordinal-1)), para saltar hacia atras
+    int ordinal;        // numero de movimiento dentro de la cuenta, desde 1
+} MovimientoHistorial;
+
+// Entrada del indice de cuentas (direccionamiento abierto, sondeo lineal)
+typedef struct
+{
+    int ocupada;
+    int numero_cuenta;
+    int num_movimientos;       // solo lo usa el escritor
+    long long ultima_marca;    // fecha del ultimo movimiento anotado (solo el escritor)
+    long long cabeza;          // ultimo movimiento publicado
+    long long cabeza_escritor; // ultimo movimiento anotado, puede no estar en disco aun
+} EntradaHistorial;
+
+// Fichero indice.dat del historial, mapeado en memoria por el escritor y los lectores
+typedef struct
+{
+    long long siguiente; // proxima posicion libre publicada
+    EntradaHistorial entradas[TAM_INDICE_HISTORIAL];
+} IndiceHistorial;
+
+int historial_abrir(const char *dir, int escritor);
+void historial_cerrar();
+
+void historial_anotar(const RegistroTx *tx);
+void historial_volcar();
+
+int historial_ultimos(int numero_cuenta, int n, MovimientoHistorial *salida);
+int historial_entre(int numero_cuenta, time_t desde, time_t hasta, MovimientoHistorial *salida, int max);
+
+#endif
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "indice_cuentas.h"
+
+#define BARRIDO_ALTA 2 // posiciones que revisa cada alta en busca de caducadas
+
+static unsigned int hueco_inicial(const IndiceCuentas *indice, int numero_cuenta)
+{
+    return ((unsigned int)numero_cuenta * 2654435761u) & (2 * indice->capacidad - 1);
+}
+
+// Reserva un indice de capacidad entradas (potencia de 2)
+// caducada dice si la entrada de una posicion ya no tiene actividad en la marca,
+// liberar se llama al borrarla para que el modulo limpie su estado
+// retorno de 0 si todo va bien, -1 en caso de error
+int indice_iniciar(IndiceCuentas *indice, int capacidad, FuncionCaducada caducada, FuncionLiberar liberar)
+{
+    indice->capacidad = capacidad;
+    indice->huecos = calloc(2 * (size_t)capacidad, sizeof(HuecoIndice));
+    indice->cuenta_de = calloc(capacidad, sizeof(int));
+    indice->libres = malloc(capacidad * sizeof(int));
+    if (indice->huecos == NULL || indice->cuenta_de == NULL || indice->libres == NULL)
+    {
+        perror("calloc indice de cuentas");
+        return -1;
+    }
+    // se apilan al reves para repartir primero las posiciones bajas
+    for (int i = 0; i < capacidad; i++)
+        indice->libres[i] = capacidad - 1 - i;
+    indice->num_libres = capacidad;
+    indice->barrido = 0;
+    indice->caducada = caducada;
+    indice->liberar = liberar;
+    indice->avisado_lleno = 0;
+    return 0;
+}
+
+// Posicion de la cuenta, aunque haya caducado y aun no se haya borrado
+// retorno de -1 si no esta
+int indice_buscar(const IndiceCuentas *indice, int numero_cuenta)
+{
+    unsigned int mascara = 2 * indice->capacidad - 1;
+    for (unsigned int h = hueco_inicial(indice, numero_cuenta); indice->huecos[h].numero_cuenta != 0;
+         h = (h + 1) & mascara)
+    {
+        if (indice->huecos[h].numero_cuenta == numero_cuenta)
+            return indice->huecos[h].posicion;
+    }
+    return -1;
+}
+
+// Quita la entrada de la posicion y rellena el hueco con las que venian
+// detras en la cadena y no pueden quedar antes de su hueco inicial
+static void borrar(IndiceCuentas *indice, int posicion)
+{
+    unsigned int mascara = 2 * indice->capacidad - 1;
+    unsigned int i = hueco_inicial(indice, indice->cuenta_de[posicion]);
+    while (indice->huecos[i].posicion != posicion || indice->huecos[i].numero_cuenta == 0)
+        i = (i + 1) & mascara;
+
+    for (unsigned int j = (i + 1) & mascara; indice->huecos[j].numero_cuenta != 0; j = (j + 1) & mascara)
+    {
+        unsigned int k = hueco_inicial(indice, indice->huecos[j].numero_cuenta);
+        // k ciclicamente en (i, j]: la entrada ya esta en su sitio
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+        indice->huecos[i] = indice->huecos[j];
+        i = j;
+    }
+    indice->huecos[i].numero_cuenta = 0;
+
+    indice->cuenta_de[posicion] = 0;
+    indice->libres[indice->num_libres++] = posicion;
+    indice->liberar(posicion);
+}
+
+// Revisa las siguientes cuantas posiciones y borra las caducadas
+static void barrer(IndiceCuentas *indice, long long marca, int cuantas)
+{
+    for (int n = 0; n < cuantas; n++)
+    {
+        int posicion = indice->barrido;
+        indice->barrido = (indice->barrido + 1) & (indice->capacidad - 1);
+        if (indice->cuenta_de[posicion] != 0 && indice->caducada(posicion, marca))
+            borrar(indice, posicion);
+    }
+}
+
+// Posicion de la cuenta, dandola de alta si no esta
+// Cada alta barre unas pocas posiciones, asi las caducadas se liberan poco a
+// poco; solo con el almacen lleno se da una vuelta entera buscando sitio
+// nueva recibe 1 si la entrada es nueva y el modulo tiene que iniciarla
+// retorno de la posicion, -1 si el almacen esta lleno de cuentas activas
+int indice_alta(IndiceCuentas *indice, int numero_cuenta, long long marca, int *nueva)
+{
+    *nueva = 0;
+    if (numero_cuenta == 0)
+        return -1; // 0 marca los huecos libres
+    int posicion = indice_buscar(indice, numero_cuenta);
+    if (posicion != -1)
+        return posicion;
+
+    barrer(indice, marca, BARRIDO_ALTA);
+    if (indice->num_libres == 0)
+        barrer(indice, marca, indice->capacidad);
+    if (indice->num_libres == 0)
+    {
+        if (!indice->avisado_lleno)
+            fprintf(stderr, "Indice de cuentas del monitor lleno, cuentas sin vigilar\n");
+        indice->avisado_lleno = 1;
+        return -1;
+    }
+
+    posicion = indice->libres[--indice->num_libres];
+    indice->cuenta_de[posicion] = numero_cuenta;
+    unsigned int mascara = 2 * indice->capacidad - 1;
+    unsigned int h = hueco_inicial(indice, numero_cuenta);
+    while (indice->huecos[h].numero_cuenta != 0)
+        h = (h + 1) & mascara;
+    indice->huecos[h] = (HuecoIndice){numero_cuenta, posicion};
+    *nueva = 1;
+    return posicion;
+}
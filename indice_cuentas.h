@@ -0,0 +1,38 @@
+#ifndef INDICE_CUENTAS_H
+#define INDICE_CUENTAS_H
+
+// Una entrada del almacen del modulo, indicada por su posicion
+typedef int (*FuncionCaducada)(int posicion, long long marca);
+typedef void (*FuncionLiberar)(int posicion);
+
+// Hueco de la tabla hash: cuenta y posicion de su entrada (cuenta 0 = libre)
+typedef struct
+{
+    int numero_cuenta;
+    int posicion;
+} HuecoIndice;
+
+// Indice de cuentas de tamanio fijo para el estado del monitor
+// La tabla hash (sondeo lineal) tiene el doble de huecos que entradas el
+// almacen, asi las cadenas de sondeo son cortas aunque el almacen este lleno.
+// Las entradas no se mueven: el modulo guarda su estado en un vector propio en
+// la misma posicion. Las caducadas se borran del hash desplazando la cadena
+// hacia atras (sin marcas de borrado) y su posicion vuelve a quedar libre
+typedef struct
+{
+    int capacidad;            // entradas del almacen (potencia de 2)
+    HuecoIndice *huecos;      // 2 * capacidad
+    int *cuenta_de;           // cuenta de cada posicion, 0 si esta libre
+    int *libres;              // pila de posiciones libres
+    int num_libres;
+    int barrido;              // siguiente posicion que revisa el barrido de caducadas
+    FuncionCaducada caducada;
+    FuncionLiberar liberar;
+    int avisado_lleno;
+} IndiceCuentas;
+
+int indice_iniciar(IndiceCuentas *indice, int capacidad, FuncionCaducada caducada, FuncionLiberar liberar);
+int indice_buscar(const IndiceCuentas *indice, int numero_cuenta);
+int indice_alta(IndiceCuentas *indice, int numero_cuenta, long long marca, int *nueva);
+
+#endif
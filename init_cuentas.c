@@ -2,16 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define CUENTAS "cuentas.dat"
+#include "tabla_cuentas.h"
 
-typedef struct {
-    int numero_cuenta;
-    char titular[100];
-    float saldo;
-    int pin;
-    int num_transacciones;
-    int bloqueado;
-} CuentaBancaria;
+#define CUENTAS "cuentas.dat"
 
 void crearCuentas(){
 
@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lote.h"
+#include "ejecutor.h"
+#include "histograma.h"
+#include "operaciones.h"
+
+#define TAM_ID_LOTE 64
+
+// Datos de cada operacion en vuelo que no pasan por el ejecutor,
+// en la misma posicion del anillo que su descriptor
+typedef struct
+{
+    long linea;
+    char id[TAM_ID_LOTE]; // valor JSON tal cual, con comillas si es texto
+    long long enviada;    // ns
+} PeticionLote;
+
+typedef struct
+{
+    const char *nombre;
+    TipoOperacion tipo;
+} NombreOperacion;
+
+static const NombreOperacion nombres_operacion[] = {
+    {"deposito", OPERACION_DEPOSITO},
+    {"retiro", OPERACION_RETIRO},
+    {"transferencia", OPERACION_TRANSFERENCIA},
+    {"consulta", OPERACION_CONSULTA},
+    {"deposit", OPERACION_DEPOSITO},
+    {"withdraw", OPERACION_RETIRO},
+    {"transfer", OPERACION_TRANSFERENCIA},
+    {"query", OPERACION_CONSULTA},
+};
+
+// Nombre con el que se escribe cada tipo en los resultados
+static const char *texto_operacion[] = {"deposito", "retiro", "transferencia", "consulta"};
+
+static EjecutorOperaciones ejecutor_lote;
+static PeticionLote peticiones[MAX_OPERACIONES_PENDIENTES];
+static unsigned long enviadas = 0;
+static unsigned long recogidas = 0;
+static long correctas = 0;
+static long fallidas = 0;
+static long no_validas = 0;
+static Histograma latencias;
+
+static long long ahora_ns()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+// Busca "clave": en un objeto JSON plano y devuelve el inicio de su valor
+// Basta para los registros del lote, sin objetos ni listas anidados
+static const char *valor_json(const char *linea, const char *clave)
+{
+    char patron[32];
+    int n = snprintf(patron, sizeof(patron), "\"%s\"", clave);
+    const char *p = linea;
+    while ((p = strstr(p, patron)) != NULL)
+    {
+        p += n;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (*p == ':')
+        {
+            p++;
+            while (*p == ' ' || *p == '\t')
+                p++;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// Copia el valor tal cual (texto con comillas o numero)
+// retorno de la longitud, 0 si no hay valor
+static int valor_crudo(const char *valor, char *destino, int tam)
+{
+    const char *fin = valor;
+    if (*fin == '"')
+    {
+        for (fin++; *fin != '\0' && *fin != '"'; fin++)
+            if (*fin == '\\' && fin[1] != '\0')
+                fin++;
+        if (*fin == '"')
+            fin++;
+    }
+    else
+    {
+        while (*fin != '\0' && *fin != ',' && *fin != '}' && *fin != ' ' && *fin != '\n' && *fin != '\r')
+            fin++;
+    }
+    int n = fin - valor;
+    if (n >= tam)
+        n = 0; // un id que no cabe se omite
+    memcpy(destino, valor, n);
+    destino[n] = '\0';
+    return n;
+}
+
+static int numero_json(const char *linea, const char *clave, double *numero)
+{
+    const char *valor = valor_json(linea, clave);
+    if (valor == NULL)
+        return -1;
+    char *fin;
+    *numero = strtod(valor, &fin);
+    return fin == valor ? -1 : 0;
+}
+
+// Convierte una linea en un descriptor
+// retorno de 0 si todo va bien, -1 si el registro no es valido
+static int leer_peticion(const char *linea, DescriptorOperacion *operacion, char *id)
+{
+    const char *op = valor_json(linea, "op");
+    if (op == NULL || *op != '"')
+        return -1;
+    op++;
+
+    int encontrada = 0;
+    for (size_t i = 0; i < sizeof(nombres_operacion) / sizeof(nombres_operacion[0]); i++)
+    {
+        size_t n = strlen(nombres_operacion[i].nombre);
+        if (strncmp(op, nombres_operacion[i].nombre, n) == 0 && op[n] == '"')
+        {
+            operacion->tipo = nombres_operacion[i].tipo;
+            encontrada = 1;
+            break;
+        }
+    }
+    if (!encontrada)
+        return -1;
+
+    double cuenta, destino = 0, cantidad = 0;
+    if (numero_json(linea, "cuenta", &cuenta) == -1)
+        return -1;
+    if (operacion->tipo == OPERACION_TRANSFERENCIA && numero_json(linea, "destino", &destino) == -1)
+        return -1;
+    if (operacion->tipo != OPERACION_CONSULTA && numero_json(linea, "cantidad", &cantidad) == -1)
+        return -1;
+
+    operacion->numero_cuenta = (int)cuenta;
+    operacion->cuenta_destino = (int)destino;
+    operacion->cantidad = (float)cantidad;
+
+    const char *valor_id = valor_json(linea, "id");
+    id[0] = '\0';
+    if (valor_id != NULL)
+        valor_crudo(valor_id, id, TAM_ID_LOTE);
+    return 0;
+}
+
+// Primera parte comun de una linea de resultado
+static void escribir_cabecera(long linea, const char *id)
+{
+    printf("{\"linea\":%ld", linea);
+    if (id[0] != '\0')
+        printf(",\"id\":%s", id);
+}
+
+// Recoge la operacion mas antigua y escribe su resultado
+static void recoger_resultado()
+{
+    DescriptorOperacion resultado;
+    if (ejecutor_esperar(&ejecutor_lote, &resultado) == -1)
+        return;
+    PeticionLote *peticion = &peticiones[recogidas % MAX_OPERACIONES_PENDIENTES];
+    recogidas++;
+    histograma_anotar(&latencias, ahora_ns() - peticion->enviada);
+
+    escribir_cabecera(peticion->linea, peticion->id);
+    printf(",\"op\":\"%s\",\"cuenta\":%d", texto_operacion[resultado.tipo], resultado.numero_cuenta);
+    if (resultado.codigo == OP_CORRECTA)
+    {
+        printf(",\"resultado\":\"OK\",\"saldo\":%.2f}\n", resultado.cuenta.saldo);
+        correctas++;
+    }
+    else
+    {
+        printf(",\"resultado\":\"ERROR\",\"mensaje\":\"%s\"}\n", operacion_mensaje(resultado.codigo));
+        fallidas++;
+    }
+}
+
+// Ejecuta el fichero con un trabajador que va por detras de la lectura:
+// hasta MAX_OPERACIONES_PENDIENTES operaciones en vuelo que se confirman juntas
+// con una espera al WAL por ventana, resultados en orden
+// Los resultados salen por stdout y el resumen por stderr
+// retorno de 0 si todo va bien, -1 si no se puede leer el fichero
+int lote_ejecutar(const char *ruta, volatile sig_atomic_t *parar)
+{
+    FILE *archivo = strcmp(ruta, "-") == 0 ? stdin : fopen(ruta, "r");
+    if (archivo == NULL)
+    {
+        perror("Error al abrir el fichero del lote");
+        return -1;
+    }
+    if (ejecutor_iniciar(&ejecutor_lote, 1) == -1)
+    {
+        if (archivo != stdin)
+            fclose(archivo);
+        return -1;
+    }
+    histograma_iniciar(&latencias);
+
+    char *linea = NULL;
+    size_t tam = 0;
+    long num_linea = 0;
+    long long inicio = ahora_ns();
+
+    while (!*parar && getline(&linea, &tam, archivo) != -1)
+    {
+        num_linea++;
+        if (strspn(linea, " \t\r\n") == strlen(linea))
+            continue;
+
+        DescriptorOperacion operacion = {0};
+        char id[TAM_ID_LOTE];
+        if (leer_peticion(linea, &operacion, id) == -1)
+        {
+            // se vacia lo pendiente para que los resultados sigan en orden
+            while (recogidas < enviadas)
+                recoger_resultado();
+            printf("{\"linea\":%ld,\"resultado\":\"ERROR\",\"mensaje\":\"Peticion no valida\"}\n", num_linea);
+            no_validas++;
+            continue;
+        }
+
+        long long enviada = ahora_ns();
+        while (ejecutor_enviar(&ejecutor_lote, &operacion) == -1)
+            recoger_resultado(); // anillo lleno
+        // la posicion solo queda libre cuando se ha recogido la operacion anterior
+        PeticionLote *peticion = &peticiones[enviadas % MAX_OPERACIONES_PENDIENTES];
+        peticion->linea = num_linea;
+        peticion->enviada = enviada;
+        strcpy(peticion->id, id);
+        enviadas++;
+
+        // lo ya ejecutado se recoge sin esperar, para medir bien la latencia
+        for (int listas = ejecutor_terminadas(&ejecutor_lote); listas > 0; listas--)
+            recoger_resultado();
+    }
+    while (recogidas < enviadas)
+        recoger_resultado();
+
+    double segundos = (ahora_ns() - inicio) / 1e9;
+    free(linea);
+    if (archivo != stdin)
+        fclose(archivo);
+    ejecutor_detener(&ejecutor_lote);
+    fflush(stdout);
+
+    fprintf(stderr, "Lote %s: %ld peticiones, %ld correctas, %ld con error, %ld no validas en %.3f s (%.0f ops/s)\n",
+            ruta, correctas + fallidas + no_validas, correctas, fallidas, no_validas, segundos,
+            segundos > 0 ? (correctas + fallidas) / segundos : 0.0);
+    fprintf(stderr, "Latencia (us): media %.1f | p50 %.1f | p99 %.1f | p99.9 %.1f | max %.1f\n",
+            histograma_media(&latencias) / 1e3, histograma_percentil(&latencias, 50) / 1e3,
+            histograma_percentil(&latencias, 99) / 1e3, histograma_percentil(&latencias, 99.9) / 1e3,
+            latencias.maximo / 1e3);
+    // profundidad real: cuantas operaciones confirma de media cada espera al WAL
+    fprintf(stderr, "WAL: %lu operaciones anotadas en %lu esperas (%.1f por espera, ventana maxima %d)\n",
+            ejecutor_lote.anotadas, ejecutor_lote.esperas_wal,
+            ejecutor_lote.esperas_wal > 0 ? (double)ejecutor_lote.anotadas / ejecutor_lote.esperas_wal : 0.0,
+            MAX_OPERACIONES_PENDIENTES);
+    return 0;
+}
@@ -0,0 +1,14 @@
+#ifndef LOTE_H
+#define LOTE_H
+
+#include <signal.h>
+
+// Ejecucion no interactiva de un fichero JSONL con una operacion por linea:
+// {"op":"deposito","cuenta":1000,"cantidad":50}
+// {"op":"transferencia","cuenta":1000,"destino":1001,"cantidad":20,"id":"n-7"}
+// op: deposito, retiro, transferencia o consulta (o deposit, withdraw,
+// transfer, query); "id" es opcional y se repite en el resultado
+// La lectura se corta si *parar deja de ser 0 (una senal de terminacion)
+int lote_ejecutar(const char *ruta, volatile sig_atomic_t *parar);
+
+#endif
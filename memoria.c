@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "memoria.h"
+
+// Crea (o recrea vacia) una region POSIX de memoria compartida y la mapea
+// como parametro se pasa el nombre del objeto shm y su tamanio
+// retorno de la direccion de la region, NULL en caso de error
+void *memoria_crear(const char *nombre, size_t tam)
+{
+    shm_unlink(nombre);
+    int fd = shm_open(nombre, O_CREAT | O_RDWR, 0666);
+    if (fd == -1)
+    {
+        perror("shm_open");
+        return NULL;
+    }
+
+    if (ftruncate(fd, tam) == -1)
+    {
+        perror("ftruncate");
+        close(fd);
+        return NULL;
+    }
+
+    void *region = mmap(NULL, tam, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED)
+    {
+        perror("mmap");
+        return NULL;
+    }
+
+    return region;
+}
+
+// Mapea una region creada por otro proceso (normalmente el banco)
+// retorno de NULL si la region no existe
+void *memoria_adjuntar(const char *nombre, size_t tam)
+{
+    int fd = shm_open(nombre, O_RDWR, 0666);
+    if (fd == -1)
+    {
+        perror("shm_open");
+        return NULL;
+    }
+
+    void *region = mmap(NULL, tam, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED)
+    {
+        perror("mmap");
+        return NULL;
+    }
+
+    return region;
+}
+
+void memoria_liberar(void *region, size_t tam)
+{
+    if (region != NULL)
+        munmap(region, tam);
+}
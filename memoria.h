@@ -0,0 +1,10 @@
+#ifndef MEMORIA_H
+#define MEMORIA_H
+
+#include <stddef.h>
+
+void *memoria_crear(const char *nombre, size_t tam);
+void *memoria_adjuntar(const char *nombre, size_t tam);
+void memoria_liberar(void *region, size_t tam);
+
+#endif
@@ -3,188 +3,491 @@
 #include <unistd.h>
 #include <string.h>
 #include <pthread.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
 #include "config.h"
+#include "reloj.h"
+#include "registro.h"
+#include "txlog.h"
+#include "deteccion.h"
+#include "grafo.h"
+#include "eventos.h"
+#include "escaner_log.h"
 
-#define FICHERO "transacciones.log"
-#define MAX_LINEA 256
-#define MAX_ALERTADAS 1000
-pthread_mutex_t mutex_log_gen = PTHREAD_MUTEX_INITIALIZER;
+#define REGISTROS_LECTURA 1024 // registros de transacciones.bin que se leen de una vez
+#define ESPERA_SONDEO 4        // segundos entre comprobaciones si no llega ningun aviso de inotify
+#define LOTE_EVENTOS 256       // eventos del anillo compartido que se procesan de una vez
+#define CHECKPOINT "monitor.ckpt"         // estado del monitor para arrancar sin releer el log
+#define CHECKPOINT_TEMPORAL "monitor.ckpt.tmp"
+#define FIRMA_CHECKPOINT "SBMCKP1"
+#define INTERVALO_CHECKPOINT 5 // segundos entre checkpoints
 
 Config configuracion_sys;
 void registro_log_general(const char *tipo, const char *descripcion);
 
-// array que registra las cuentas que ya genraron una alerta
-int ya_alertadas[MAX_ALERTADAS];
-int total_alertadas = 0;
-
 void registro_log_general(const char *tipo, const char *descripcion)
 {
-    pthread_mutex_lock(&mutex_log_gen);
+    registro_anotar(LOG_MONITOR, 0, tipo, descripcion, 0, 0);
+}
+
+// Posicion de lectura en transacciones.bin
+// El inodo permite detectar que el fichero se ha sustituido (rotado) y el
+// tamanio que se ha truncado; en ambos casos se vuelve a leer desde el inicio
+typedef struct
+{
+    int fd;
+    ino_t inodo;
+    dev_t dispositivo;
+    off_t desplazamiento; // siempre en el limite de un registro completo
+} SeguimientoLog;
+
+// Cabecera de monitor.ckpt, seguida del grafo y del estado de deteccion
+// Solo se guarda la posicion de la fuente que se estaba leyendo (anillo de
+// eventos o transacciones.bin); la otra queda a cero
+typedef struct
+{
+    char firma[8];
+    long long marca;                      // reloj_ahora() al guardar
+    unsigned long long generacion_eventos; // anillo de eventos, 0 si se seguia el log
+    unsigned long long leido_eventos;
+    ino_t inodo;                           // transacciones.bin, 0 si se seguia el anillo
+    dev_t dispositivo;
+    off_t desplazamiento;
+} CabeceraCheckpoint;
+
+static volatile sig_atomic_t terminar = 0;
+static long long ultimo_checkpoint = 0;
+
+static void manejar_senal(int sig)
+{
+    (void)sig;
+    terminar = 1;
+}
 
-    FILE *log_gen = fopen("application.log", "a");
-    if (!log_gen)
+// Aniade la transferencia al grafo y muestra sus alertas
+static void analizar_grafo(const RegistroTx *registro)
+{
+    AlertaGrafo alertas[MAX_ALERTAS_GRAFO];
+    int num_alertas = grafo_procesar(registro, alertas);
+
+    for (int i = 0; i < num_alertas; i++)
     {
-        perror("Error al abrir application.log");
-        pthread_mutex_unlock(&mutex_log_gen);
-        return;
+        char alerta[200];
+        if (alertas[i].tipo == GRAFO_DISPERSION)
+        {
+            snprintf(alerta, sizeof(alerta), "🚨 ALERTA: Cuenta %d ha transferido a %d cuentas distintas en %d segundos\n",
+                     alertas[i].numero_cuenta, alertas[i].cuentas, configuracion_sys.ventana_grafo);
+            registro_log_general("Monitor", "Alerta de dispersion de transferencias");
+        }
+        else if (alertas[i].tipo == GRAFO_CONCENTRACION)
+        {
+            snprintf(alerta, sizeof(alerta), "🚨 ALERTA: Cuenta %d ha recibido de %d cuentas distintas en %d segundos\n",
+                     alertas[i].numero_cuenta, alertas[i].cuentas, configuracion_sys.ventana_grafo);
+            registro_log_general("Monitor", "Alerta de concentracion de transferencias");
+        }
+        else if (alertas[i].ciclo[2] == 0)
+        {
+            snprintf(alerta, sizeof(alerta), "🚨 ALERTA: Ciclo de transferencias %d -> %d -> %d\n",
+                     alertas[i].ciclo[0], alertas[i].ciclo[1], alertas[i].ciclo[0]);
+            registro_log_general("Monitor", "Alerta de ciclo de transferencias");
+        }
+        else
+        {
+            snprintf(alerta, sizeof(alerta), "🚨 ALERTA: Ciclo de transferencias %d -> %d -> %d -> %d\n",
+                     alertas[i].ciclo[0], alertas[i].ciclo[1], alertas[i].ciclo[2], alertas[i].ciclo[0]);
+            registro_log_general("Monitor", "Alerta de ciclo de transferencias");
+        }
+        write(STDOUT_FILENO, alerta, strlen(alerta));
+    }
+}
+
+// Analiza una transaccion con las reglas de su operacion y muestra las alertas
+void analizar_transaccion(const RegistroTx *registro)
+{
+    Alerta alertas[MAX_ALERTAS_EVENTO];
+    int num_alertas = deteccion_procesar(registro, alertas);
+
+    for (int i = 0; i < num_alertas; i++)
+    {
+        // Generar alerta
+        const Regla *regla = alertas[i].regla;
+        char alerta[200];
+        char mensaje[80];
+        if (regla->ambito == AMBITO_CUENTA)
+        {
+            snprintf(alerta, sizeof(alerta),
+                     "🚨 ALERTA: Cuenta %d ha realizado %d %s (%.2f) en %d segundos\n",
+                     alertas[i].numero_cuenta, alertas[i].operaciones,
+                     reglas_descripcion_operacion(regla->operacion), alertas[i].importe, regla->ventana);
+        }
+        else
+        {
+            snprintf(alerta, sizeof(alerta),
+                     "🚨 ALERTA: El banco ha registrado %d %s (%.2f) en %d segundos\n",
+                     alertas[i].operaciones, reglas_descripcion_operacion(regla->operacion),
+                     alertas[i].importe, regla->ventana);
+        }
+        snprintf(mensaje, sizeof(mensaje), "Alerta de anomalia %s", regla->nombre);
+        registro_log_general("Monitor", mensaje);
+        write(STDOUT_FILENO, alerta, strlen(alerta));
     }
 
-    time_t t = time(NULL);
-    struct tm *tm_info = localtime(&t);
-    char fecha_hora[30];
-    strftime(fecha_hora, sizeof(fecha_hora), "%Y-%m-%d %H:%M:%S", tm_info);
+    analizar_grafo(registro);
+}
 
-    fprintf(log_gen, "[%s] | Tipo: %s | Descripcion: %s\n",
-            fecha_hora, tipo, descripcion);
+// Analiza solo los registros completos aniadidos desde la ultima lectura
+void leer_nuevos(SeguimientoLog *seguimiento)
+{
+    RegistroTx registros[REGISTROS_LECTURA];
+    ssize_t leidos;
 
-    fclose(log_gen);
-    pthread_mutex_unlock(&mutex_log_gen);
+    while ((leidos = pread(seguimiento->fd, registros, sizeof(registros), seguimiento->desplazamiento)) > 0)
+    {
+        // un registro a medio escribir se lee en la siguiente vuelta
+        size_t completos = leidos / sizeof(RegistroTx);
+        for (size_t i = 0; i < completos; i++)
+        {
+            analizar_transaccion(&registros[i]);
+        }
+        seguimiento->desplazamiento += completos * sizeof(RegistroTx);
+        if (completos < REGISTROS_LECTURA)
+            break;
+    }
 }
 
-// Verifica si una cuenta ha generado una alerta
-// retorno de 1 si ya se ha generado, 0 si no
-int ya_alertada(int cuenta)
+// Comprueba si el log se ha rotado o truncado y lo (re)abre si hace falta
+// retorno de 0 si el log esta abierto, -1 si todavia no existe
+int preparar_log(SeguimientoLog *seguimiento)
 {
-    // recorrer el array
-    for (int i = 0; i < total_alertadas; i++)
+    struct stat st;
+    if (stat(TXLOG, &st) == -1)
     {
-        if (ya_alertadas[i] == cuenta)
-            return 1;
+        return seguimiento->fd == -1 ? -1 : 0; // se sigue leyendo lo que quede del anterior
+    }
+
+    if (seguimiento->fd != -1 && (st.st_ino != seguimiento->inodo || st.st_dev != seguimiento->dispositivo))
+    {
+        // fichero nuevo con el mismo nombre: rotacion
+        // se termina de leer el anterior antes de pasar al nuevo
+        leer_nuevos(seguimiento);
+        close(seguimiento->fd);
+        seguimiento->fd = -1;
+        registro_log_general("Monitor", "Log de transacciones rotado, lectura desde el inicio");
+    }
+
+    if (seguimiento->fd == -1)
+    {
+        seguimiento->fd = open(TXLOG, O_RDONLY);
+        if (seguimiento->fd == -1)
+        {
+            perror("No se pudo abrir el fichero de transacciones.bin");
+            return -1;
+        }
+        // la posicion del checkpoint solo vale para el mismo fichero
+        if (st.st_ino != seguimiento->inodo || st.st_dev != seguimiento->dispositivo ||
+            st.st_size < seguimiento->desplazamiento)
+        {
+            seguimiento->desplazamiento = 0;
+        }
+        seguimiento->inodo = st.st_ino;
+        seguimiento->dispositivo = st.st_dev;
+    }
+    else if (st.st_size < seguimiento->desplazamiento)
+    {
+        // el mismo fichero es mas corto que lo ya leido: truncado
+        seguimiento->desplazamiento = 0;
+        registro_log_general("Monitor", "Log de transacciones truncado, lectura desde el inicio");
     }
     return 0;
 }
 
-// registrar una cuenta en estado de alerta
-void registrar_alerta(int cuenta)
+// Avisos de inotify sobre el directorio del log: escritura, creacion y
+// sustitucion de transacciones.bin
+// retorno del descriptor de inotify, -1 si no esta disponible (se sondea)
+int vigilar_log()
 {
-    if (total_alertadas < MAX_ALERTADAS)
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd == -1)
+    {
+        perror("inotify_init1");
+        return -1;
+    }
+    if (inotify_add_watch(fd, ".", IN_MODIFY | IN_CREATE | IN_MOVED_TO | IN_CLOSE_WRITE) == -1)
     {
-        ya_alertadas[total_alertadas++] = cuenta;
+        perror("inotify_add_watch");
+        close(fd);
+        return -1;
     }
+    return fd;
 }
 
-int main()
+// Espera a que cambie el log o venza el intervalo de sondeo
+void esperar_cambios(int fd_inotify)
 {
-    // contadores para la deteccion
-    int contador_retiros = 1;       // comparador con umbral_retiro
-    int contador_tranferencias = 1; // comparador umbral_transferencias
-    int contador_intervalo_transferencia = 0;
+    if (fd_inotify == -1)
+    {
+        pausa_sondeo(ESPERA_SONDEO);
+        return;
+    }
 
-    configuracion_sys = leer_configuracion("config.txt");
+    struct pollfd pfd = {fd_inotify, POLLIN, 0};
+    while (poll(&pfd, 1, ESPERA_SONDEO * 1000) > 0)
+    {
+        // vaciar los avisos pendientes; solo interesan los del log de transacciones
+        char eventos[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        int del_log = 0;
+        ssize_t n;
+        while ((n = read(fd_inotify, eventos, sizeof(eventos))) > 0)
+        {
+            for (char *p = eventos; p < eventos + n;)
+            {
+                struct inotify_event *evento = (struct inotify_event *)p;
+                if (evento->len > 0 && strcmp(evento->name, TXLOG) == 0)
+                    del_log = 1;
+                p += sizeof(struct inotify_event) + evento->len;
+            }
+        }
+        if (del_log)
+            return;
+    }
+}
 
-    printf("🔍 Monitor activo. Escuchando anomalías por retiros y tranferencias reiteradas...\n");
-    registro_log_general("Monitor", "Activo, escuchando");
+// Guarda la posicion de lectura y el estado de deteccion en monitor.ckpt
+// Se escribe un fichero temporal y se renombra: un corte a medias deja el
+// checkpoint anterior intacto
+// retorno de 0 si todo va bien, -1 en caso de error
+int guardar_checkpoint(const SeguimientoLog *seguimiento, const LectorEventos *lector)
+{
+    CabeceraCheckpoint cabecera = {FIRMA_CHECKPOINT, reloj_ahora(), 0, 0, 0, 0, 0};
+    if (lector != NULL)
+    {
+        cabecera.generacion_eventos = lector->generacion;
+        cabecera.leido_eventos = lector->leido;
+    }
+    if (seguimiento != NULL)
+    {
+        cabecera.inodo = seguimiento->inodo;
+        cabecera.dispositivo = seguimiento->dispositivo;
+        cabecera.desplazamiento = seguimiento->desplazamiento;
+    }
+
+    FILE *archivo = fopen(CHECKPOINT_TEMPORAL, "wb");
+    if (archivo == NULL)
+    {
+        perror("Error al crear el checkpoint del monitor");
+        return -1;
+    }
+    int error = fwrite(&cabecera, sizeof(cabecera), 1, archivo) != 1 ||
+                grafo_guardar(archivo, cabecera.marca) == -1 ||
+                deteccion_guardar(archivo, cabecera.marca) == -1 ||
+                fflush(archivo) != 0 || fsync(fileno(archivo)) == -1;
+    fclose(archivo);
+
+    if (error || rename(CHECKPOINT_TEMPORAL, CHECKPOINT) == -1)
+    {
+        perror("Error al escribir el checkpoint del monitor");
+        unlink(CHECKPOINT_TEMPORAL);
+        return -1;
+    }
+    ultimo_checkpoint = cabecera.marca;
+    return 0;
+}
+
+// Recupera el estado de monitor.ckpt
+// El coste depende solo de las cuentas activas guardadas, no del tamanio del log
+// retorno de 0 si hay checkpoint valido, -1 si se empieza sin estado
+int cargar_checkpoint(CabeceraCheckpoint *cabecera)
+{
+    FILE *archivo = fopen(CHECKPOINT, "rb");
+    if (archivo == NULL)
+        return -1;
+
+    long long ahora = reloj_ahora();
+    if (fread(cabecera, sizeof(*cabecera), 1, archivo) != 1 ||
+        memcmp(cabecera->firma, FIRMA_CHECKPOINT, sizeof(cabecera->firma)) != 0 ||
+        grafo_cargar(archivo, ahora) == -1)
+    {
+        fclose(archivo);
+        registro_log_general("Monitor", "Checkpoint no valido, se empieza sin estado");
+        return -1;
+    }
+    if (deteccion_cargar(archivo, ahora) == -1)
+        registro_log_general("Monitor", "Reglas cambiadas, contadores de deteccion reiniciados");
+    fclose(archivo);
+    return 0;
+}
+
+// Guarda el checkpoint cada INTERVALO_CHECKPOINT segundos y al recibir
+// la senal de terminar, en cuyo caso el monitor sale
+void checkpoint_periodico(const SeguimientoLog *seguimiento, const LectorEventos *lector)
+{
+    if (terminar)
+    {
+        guardar_checkpoint(seguimiento, lector);
+        exit(0);
+    }
+    if (reloj_ahora() - ultimo_checkpoint >= INTERVALO_CHECKPOINT)
+        guardar_checkpoint(seguimiento, lector);
+}
+
+// Consume el anillo de eventos que publican los usuarios, sin tocar ficheros
+// Los eventos que los usuarios sobrescriben antes de leerlos se avisan en el log
+// Con checkpoint se continua en su posicion si el anillo sigue siendo el mismo
+static void seguir_eventos(const CabeceraCheckpoint *cabecera)
+{
+    LectorEventos lector;
+    RegistroTx eventos[LOTE_EVENTOS];
+    unsigned long long perdidos_avisados = 0;
+    unsigned long long atascos_avisados = 0;
 
-    // Bucle para el monitor
+    if (cabecera == NULL ||
+        eventos_reanudar_lector(&lector, cabecera->generacion_eventos, cabecera->leido_eventos) == -1)
+    {
+        eventos_iniciar_lector(&lector);
+    }
     while (1)
     {
-        // Abrir el fichero de trnsacciones.log
-        FILE *archivo = fopen(FICHERO, "r");
-        if (!archivo)
+        checkpoint_periodico(NULL, &lector);
+
+        int n = eventos_leer(&lector, eventos, LOTE_EVENTOS);
+        for (int i = 0; i < n; i++)
         {
-            perror("No se pudo abrir el fichero de transacciones.log");
-            sleep(2);
-            continue;
+            analizar_transaccion(&eventos[i]);
         }
 
-        // Variables para analizar la secuencia de transacciones
-        char linea[MAX_LINEA];
-        int cuenta_anterior1 = -1;
-        int cuenta_anterior2 = -1;
-        int cuenta_actual = -1;
-        char tipo_op_anterior[50];
-        char tipo_op_anterior2[50];
-        char tipo_op_actual[50];
-
-        while (fgets(linea, sizeof(linea), archivo))
+        if (lector.perdidos != perdidos_avisados)
         {
-            // Extraemos el número de cuenta de cada línea
-            int cuenta;
-            char fecha[50], tipo_op[50];
-            float monto, saldo_final;
-
-            // parsear linea del log
-            int ok = sscanf(linea,
-                            "[%[^]]] Cuenta: %d | Operación: %[^|] | Monto: %f | Saldo final: %f",
-                            fecha, &cuenta, tipo_op, &monto, &saldo_final);
-
-            // si no se extraen todos los datos salta linea
-            if (ok != 5)
-                continue;
-
-            cuenta_anterior2 = cuenta_anterior1;
-            cuenta_anterior1 = cuenta_actual;
-            cuenta_actual = cuenta;
-
-            // actualizar los tipos de operaciones
-            strcpy(tipo_op_anterior2, tipo_op_anterior);
-            strcpy(tipo_op_anterior, tipo_op_actual);
-            strcpy(tipo_op_actual, tipo_op);
-
-            // deteccion de transferencias consecutivas
-            if (strcmp(tipo_op_anterior2, "Transferencia realizada ") == 0 && cuenta_actual == cuenta_anterior2 && strcmp(tipo_op_actual, "Transferencia realizada ") == 0)
-            {
-                // incremento del contador si hay 3 transferencias seguidas
-                contador_tranferencias++;
-                contador_intervalo_transferencia = 0;
-            }
-            else
-            {
-                // reiniciar contador si hay op intermedias
-                if (contador_intervalo_transferencia == 1)
-                {
-                    contador_tranferencias = 1;
-                }
-                contador_intervalo_transferencia++;
-            }
+            char mensaje[128];
+            snprintf(mensaje, sizeof(mensaje), "%llu eventos perdidos por desborde del anillo",
+                     lector.perdidos - perdidos_avisados);
+            registro_log_general("Monitor", mensaje);
+            perdidos_avisados = lector.perdidos;
+        }
+        if (lector.perdidos_atasco != atascos_avisados)
+        {
+            char mensaje[128];
+            snprintf(mensaje, sizeof(mensaje), "%llu eventos perdidos por un usuario que termino sin publicarlos",
+                     lector.perdidos_atasco - atascos_avisados);
+            registro_log_general("Monitor", mensaje);
+            atascos_avisados = lector.perdidos_atasco;
+        }
 
-            // verificar si se ha alcanzado el umbral de tranferencias definido en config
-            if (contador_tranferencias == configuracion_sys.umbral_tranferencias && ya_alertada(cuenta_actual) == 0)
-            {
-                // Generar alerta
-                char alerta[128];
-                snprintf(alerta, sizeof(alerta),
-                         "🚨 ALERTA: Cuenta %d ha realizado %d transacciones seguidas\n",
-                         cuenta_actual, configuracion_sys.umbral_tranferencias);
-                write(STDOUT_FILENO, alerta, strlen(alerta));
+        if (n == 0)
+            eventos_esperar(&lector);
+    }
+}
 
-                registrar_alerta(cuenta_actual);
-                registro_log_general("Monitor", "Alerta de anomalia transferencia");
+// Pasa por las reglas y el grafo un log de transacciones en texto
+// (transacciones.log antiguos o salida de txlog-dump) para auditarlo
+// No usa el checkpoint ni el anillo de eventos
+void rellenar_desde_texto(const char *ruta)
+{
+    EscanerLog escaner;
+    RegistroTx registro;
+    if (escaner_abrir(&escaner, ruta) == -1)
+        exit(EXIT_FAILURE);
 
-                contador_tranferencias = 1; // reiniciar el contador
-            }
+    while (escaner_siguiente(&escaner, &registro))
+    {
+        analizar_transaccion(&registro);
+    }
+    printf("%lld lineas analizadas, %lld con otro formato\n", escaner.lineas, escaner.descartadas);
+    escaner_cerrar(&escaner);
+}
 
-            // Deteccion de retiros consecutivos
-            if (strcmp(tipo_op, "Retiro ") == 0 && cuenta_actual == cuenta_anterior1 && strcmp(tipo_op_anterior, "Retiro ") == 0)
-            {
-                contador_retiros++; // incremento del contador de retiros seguidos
-            }
-            else
-            {
-                contador_retiros = 1; // reinciar el contador
-            }
+// Uso: monitor                       vigila las operaciones en curso
+//      monitor --backfill fichero    analiza un log de texto y termina
+int main(int argc, char *argv[])
+{
+    SeguimientoLog seguimiento = {0};
+    seguimiento.fd = -1;
 
-            // verificar si se alcanzo el umbral de retiros definido en config
-            if (contador_retiros == configuracion_sys.umbral_retiros && ya_alertada(cuenta_actual) == 0)
-            {
-                // generar alerta
-                char alerta[128];
-                snprintf(alerta, sizeof(alerta),
-                         "🚨 ALERTA: Cuenta %d ha realizado %d retiros seguidas\n",
-                         cuenta_actual, configuracion_sys.umbral_retiros);
-                write(STDOUT_FILENO, alerta, strlen(alerta));
+    // killall al cerrar el banco: se guarda el checkpoint antes de salir
+    struct sigaction accion = {0};
+    accion.sa_handler = manejar_senal;
+    sigaction(SIGTERM, &accion, NULL);
+    sigaction(SIGINT, &accion, NULL);
 
-                registrar_alerta(cuenta_actual);
-                registro_log_general("Monitor", "Alerta de anomalia retiro");
+    configuracion_sys = leer_configuracion("config.txt");
+    // ritmo de las pausas y hora de los logs (MODO_RELOJ)
+    reloj_iniciar(reloj_modo(configuracion_sys.modo_reloj));
 
-                contador_retiros = 1; // reinciar el contador
-            }
+    // anillo de logs del banco, sin el los logs se escriben desde este proceso
+    registro_adjuntar();
+
+    // reglas de deteccion de ARCHIVO_REGLAS compiladas en una tabla por operacion;
+    // sin fichero se usan los umbrales de config.txt con ventanas de VENTANA_ANOMALIAS segundos
+    TablaReglas reglas;
+    if (reglas_cargar(configuracion_sys.archivo_reglas, &reglas) == -1)
+    {
+        if (configuracion_sys.ventana_anomalias <= 0)
+            configuracion_sys.ventana_anomalias = 60;
+        reglas_por_defecto(&reglas, configuracion_sys.ventana_anomalias, configuracion_sys.umbral_retiros,
+                           configuracion_sys.umbral_tranferencias);
+    }
+    if (deteccion_iniciar(&reglas) == -1)
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    // grafo de transferencias recientes: dispersion, concentracion y ciclos
+    if (configuracion_sys.ventana_grafo <= 0)
+        configuracion_sys.ventana_grafo = 300;
+    if (configuracion_sys.umbral_dispersion <= 0)
+        configuracion_sys.umbral_dispersion = 5;
+    if (configuracion_sys.umbral_concentracion <= 0)
+        configuracion_sys.umbral_concentracion = 5;
+    if (grafo_iniciar(configuracion_sys.ventana_grafo, configuracion_sys.umbral_dispersion,
+                      configuracion_sys.umbral_concentracion) == -1)
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    if (argc > 2 && strcmp(argv[1], "--backfill") == 0)
+    {
+        rellenar_desde_texto(argv[2]);
+        return 0;
+    }
+
+    printf("🔍 Monitor activo. Escuchando anomalías por retiros y tranferencias reiteradas...\n");
+    registro_log_general("Monitor", "Activo, escuchando");
+
+    // estado guardado en el ultimo checkpoint
+    CabeceraCheckpoint cabecera;
+    int con_checkpoint = cargar_checkpoint(&cabecera) == 0;
+    if (con_checkpoint)
+    {
+        seguimiento.inodo = cabecera.inodo;
+        seguimiento.dispositivo = cabecera.dispositivo;
+        seguimiento.desplazamiento = cabecera.desplazamiento;
+        registro_log_general("Monitor", "Estado recuperado del checkpoint");
+    }
+    ultimo_checkpoint = reloj_ahora();
+
+    // eventos en memoria compartida publicados por los usuarios
+    if (eventos_adjuntar() == 0)
+    {
+        seguir_eventos(con_checkpoint ? &cabecera : NULL);
+    }
+
+    // sin el anillo de eventos se sigue el log de transacciones
+    // inotify avisa de cada escritura del log; sin el se sondea cada ESPERA_SONDEO segundos
+    int fd_inotify = vigilar_log();
+
+    // Bucle para el monitor: solo se procesan los bytes nuevos del log
+    while (1)
+    {
+        checkpoint_periodico(&seguimiento, NULL);
+        if (preparar_log(&seguimiento) == 0)
+        {
+            leer_nuevos(&seguimiento);
         }
 
-        // Cerrar el fichero y esperar
-        fclose(archivo);
-        sleep(4); // Espera antes de volver a revisar
+        esperar_cambios(fd_inotify);
     }
 
     return 0;
-}
\ No newline at end of file
+}
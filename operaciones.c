@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include "operaciones.h"
+#include "wal.h"
+#include "escritura.h"
+#include "reloj.h"
+#include "registro.h"
+#include "txlog.h"
+#include "eventos.h"
+
+// Operaciones sobre las cuentas compartidas, sin entrada ni salida por terminal
+// Las usan el proceso usuario y el servidor de sesiones del banco; cada
+// proceso debe tener adjuntados antes la tabla, el WAL, el buffer de
+// escritura, el anillo de logs y el de eventos
+
+// Estado local del proceso
+static TablaCuentas *tabla_operaciones = NULL;
+static const Config *config_operaciones = NULL;
+
+void operaciones_iniciar(TablaCuentas *tabla, const Config *config)
+{
+    tabla_operaciones = tabla;
+    config_operaciones = config;
+}
+
+// Texto de un resultado para mostrarlo al usuario
+const char *operacion_mensaje(int codigo)
+{
+    switch (codigo)
+    {
+    case OP_CORRECTA:
+        return "Operacion realizada";
+    case OP_CUENTA_NO_EXISTE:
+        return "Cuenta no encontrada";
+    case OP_FONDOS_INSUFICIENTES:
+        return "Fondos insuficientes";
+    case OP_LIMITE_EXCEDIDO:
+        return "El monto excede el limite de la operacion";
+    case OP_IMPORTE_NO_VALIDO:
+        return "Importe no valido";
+    case OP_PIN_INCORRECTO:
+        return "PIN incorrecto";
+    case OP_ERROR_WAL:
+        return "No se pudo registrar la operacion, intentelo mas tarde";
+    }
+    return "Error desconocido";
+}
+
+// Registro de transacciones en el log binario transacciones.bin (txlog-dump lo muestra como texto)
+// Los registros se dejan en el anillo de logs del banco, no se abre ningun fichero
+// y ademas se publican como eventos en el anillo que consume el monitor
+static void registrar_transaccion(int operacion, int numero_cuenta, int contraparte, float monto, float saldo_final)
+{
+    registro_anotar_tx(operacion, numero_cuenta, contraparte, monto, saldo_final);
+
+    RegistroTx evento = {reloj_ahora(), numero_cuenta, contraparte, operacion, monto, saldo_final};
+    eventos_publicar(&evento);
+}
+
+static void registro_log_general(const char *tipo, int numero_cuenta, const char *descripcion)
+{
+    registro_anotar(LOG_USUARIO, numero_cuenta, tipo, descripcion, 0, 0);
+}
+
+// Devuelve la cuenta al estado anterior a un cambio que no llego al WAL
+// Se llama con la franja todavia bloqueada; se restauran los valores guardados,
+// no se resta el importe, para no arrastrar redondeos del float
+// Se marca la ranura por si un volcado o un punto de control copio el cambio
+static void deshacer_cambio(RanuraCuenta *ranura, const CuentaBancaria *anterior)
+{
+    ranura_inicio_escritura(ranura);
+    ranura->cuenta.saldo = anterior->saldo;
+    ranura->cuenta.num_transacciones = anterior->num_transacciones;
+    ranura_fin_escritura(ranura);
+    buffer_marcar(ranura);
+}
+
+// Ingresa cantidad en la cuenta
+// resultado recibe la cuenta tras la operacion
+// lsn_anotado recibe el lsn que hay que esperar para confirmarlo, 0 si no hay nada que esperar
+// retorno de OP_CORRECTA o el codigo OP_* del rechazo
+int operacion_depositar_sin_esperar(int numero_cuenta, float cantidad, CuentaBancaria *resultado,
+                                    unsigned long long *lsn_anotado)
+{
+    TablaCuentas *tabla = tabla_operaciones;
+
+    if (!(cantidad > 0))
+    {
+        registro_log_general("Depósito", numero_cuenta, "Deposito rechazado por importe no valido");
+        return OP_IMPORTE_NO_VALIDO;
+    }
+
+    // busqueda y actualizacion de la cuenta
+    RanuraCuenta *ranura = tabla_buscar_ranura(tabla, numero_cuenta);
+    if (ranura == NULL)
+        return OP_CUENTA_NO_EXISTE;
+
+    CuentaBancaria *cuenta_mc = &ranura->cuenta;
+    tabla_bloquear_cuenta(tabla, numero_cuenta);
+
+    // Realiza operacion en memoria
+    CuentaBancaria anterior = *cuenta_mc;
+    ranura_inicio_escritura(ranura);
+    cuenta_mc->saldo += cantidad;
+    cuenta_mc->num_transacciones++;
+    ranura_fin_escritura(ranura);
+    *resultado = *cuenta_mc;
+
+    // anotar en el WAL con la franja bloqueada para mantener el orden
+    RegistroWal registro;
+    wal_preparar(&registro, cuenta_mc, cantidad);
+    unsigned long long lsn = wal_anotar(&registro, 1);
+    if (lsn == 0)
+    {
+        deshacer_cambio(ranura, &anterior);
+        tabla_desbloquear_cuenta(tabla, numero_cuenta);
+        registro_log_general("Depósito", numero_cuenta, "Deposito anulado por error al escribir el WAL");
+        return OP_ERROR_WAL;
+    }
+    tabla_desbloquear_cuenta(tabla, numero_cuenta);
+
+    // la escritura en disco toma el estado mas reciente, no importa el orden
+    buffer_marcar(ranura);
+
+    // el deposito se confirma cuando el WAL esta en disco, lo espera quien llama
+    *lsn_anotado = lsn;
+
+    registrar_transaccion(TX_DEPOSITO, numero_cuenta, 0, cantidad, resultado->saldo);
+    registro_log_general("Depósito", numero_cuenta, "Usuario ha realizado un depósito");
+    return OP_CORRECTA;
+}
+
+// Retira cantidad de la cuenta si hay fondos y no supera LIMITE_RETIRO
+// resultado recibe la cuenta tras la operacion
+// lsn_anotado como en operacion_depositar_sin_esperar
+// retorno de OP_CORRECTA o el codigo OP_* del rechazo
+int operacion_retirar_sin_esperar(int numero_cuenta, float cantidad, CuentaBancaria *resultado,
+                                  unsigned long long *lsn_anotado)
+{
+    TablaCuentas *tabla = tabla_operaciones;
+
+    if (!(cantidad > 0))
+    {
+        registro_log_general("Retiro", numero_cuenta, "Retiro rechazado por importe no valido");
+        return OP_IMPORTE_NO_VALIDO;
+    }
+
+    // busqueda de la cuenta solicitada mediante el indice
+    RanuraCuenta *ranura = tabla_buscar_ranura(tabla, numero_cuenta);
+    if (ranura == NULL)
+        return OP_CUENTA_NO_EXISTE;
+
+    CuentaBancaria *cuenta_mc = &ranura->cuenta;
+
+    // bloqueo de la franja de la cuenta: comprobacion y cargo son atomicos
+    tabla_bloquear_cuenta(tabla, numero_cuenta);
+
+    // verificar fondos
+    if (cantidad > cuenta_mc->saldo)
+    {
+        tabla_desbloquear_cuenta(tabla, numero_cuenta);
+        registro_log_general("Retiro", numero_cuenta, "Retiro rechazado por fondos insuficientes");
+        return OP_FONDOS_INSUFICIENTES;
+    }
+    // verificar exceso en la cantidad de config
+    if (cantidad > config_operaciones->limite_retiro)
+    {
+        tabla_desbloquear_cuenta(tabla, numero_cuenta);
+        registro_log_general("Retiro", numero_cuenta, "Retiro rechazado por exceder limite");
+        return OP_LIMITE_EXCEDIDO;
+    }
+
+    // realizar retiro y actualiza la memoria
+    CuentaBancaria anterior = *cuenta_mc;
+    ranura_inicio_escritura(ranura);
+    cuenta_mc->saldo -= cantidad;
+    cuenta_mc->num_transacciones++;
+    ranura_fin_escritura(ranura);
+    *resultado = *cuenta_mc;
+
+    // se anota en el WAL con la franja bloqueada para mantener el orden
+    RegistroWal registro;
+    wal_preparar(&registro, cuenta_mc, -cantidad);
+    unsigned long long lsn = wal_anotar(&registro, 1);
+    if (lsn == 0)
+    {
+        deshacer_cambio(ranura, &anterior);
+        tabla_desbloquear_cuenta(tabla, numero_cuenta);
+        registro_log_general("Retiro", numero_cuenta, "Retiro anulado por error al escribir el WAL");
+        return OP_ERROR_WAL;
+    }
+    tabla_desbloquear_cuenta(tabla, numero_cuenta);
+
+    buffer_marcar(ranura);
+
+    // el retiro se confirma cuando el WAL esta en disco, lo espera quien llama
+    *lsn_anotado = lsn;
+
+    registro_log_general("Retiro", numero_cuenta, "Usuario ha realizado un retiro");
+    registrar_transaccion(TX_RETIRO, numero_cuenta, 0, cantidad, resultado->saldo);
+    return OP_CORRECTA;
+}
+
+// Transfiere cantidad entre dos cuentas si hay fondos y no supera LIMITE_TRANSFERENCIA
+// resultado recibe la cuenta de origen tras la operacion
+// lsn_anotado como en operacion_depositar_sin_esperar
+// retorno de OP_CORRECTA o el codigo OP_* del rechazo
+int operacion_transferir_sin_esperar(int num_origen, int num_destino, float cantidad, CuentaBancaria *resultado,
+                                     unsigned long long *lsn_anotado)
+{
+    TablaCuentas *tabla = tabla_operaciones;
+
+    if (!(cantidad > 0))
+    {
+        registro_log_general("Transferencia fallida", num_origen, "Rechazada por importe no valido");
+        return OP_IMPORTE_NO_VALIDO;
+    }
+
+    // busqueda de cuentas en la memoria compartida mediante el indice
+    RanuraCuenta *ranura_origen = tabla_buscar_ranura(tabla, num_origen);
+    RanuraCuenta *ranura_destino = tabla_buscar_ranura(tabla, num_destino);
+
+    // verifiacion de existencia de ambas cuentas
+    if (!ranura_origen || !ranura_destino)
+    {
+        registro_log_general("Transferencia fallida", num_origen, "Cuenta no encontrada");
+        return OP_CUENTA_NO_EXISTE;
+    }
+
+    CuentaBancaria *cuenta_origen = &ranura_origen->cuenta;
+    CuentaBancaria *cuenta_destino = &ranura_destino->cuenta;
+
+    // bloqueo de las franjas de ambas cuentas, solo se serializan las transferencias que comparten cuenta
+    tabla_bloquear_par(tabla, num_origen, num_destino);
+
+    // verificacion de fondos
+    if (cantidad > cuenta_origen->saldo)
+    {
+        tabla_desbloquear_par(tabla, num_origen, num_destino);
+        registro_log_general("Transferencia fallida", num_origen, "Rechazada por fondos insuficientes");
+        return OP_FONDOS_INSUFICIENTES;
+    }
+
+    // verificar limite de transferencia con config
+    if (cantidad > config_operaciones->limite_tranferencia)
+    {
+        tabla_desbloquear_par(tabla, num_origen, num_destino);
+        registro_log_general("Transferencia fallida", num_origen, "Rechazada tras exceder limite");
+        return OP_LIMITE_EXCEDIDO;
+    }
+
+    // Realizar la transferencia en memoria compartida
+    CuentaBancaria anterior_origen = *cuenta_origen;
+    CuentaBancaria anterior_destino = *cuenta_destino;
+    ranura_inicio_escritura(ranura_origen);
+    if (ranura_destino != ranura_origen)
+        ranura_inicio_escritura(ranura_destino);
+    cuenta_origen->saldo -= cantidad;
+    cuenta_destino->saldo += cantidad;
+    cuenta_origen->num_transacciones++;
+    if (ranura_destino != ranura_origen)
+        ranura_fin_escritura(ranura_destino);
+    ranura_fin_escritura(ranura_origen);
+
+    // origen y destino van al WAL en una sola escritura, se recuperan juntos o ninguno
+    RegistroWal registros[2];
+    wal_preparar(&registros[0], cuenta_origen, -cantidad);
+    wal_preparar(&registros[1], cuenta_destino, cantidad);
+    unsigned long long lsn = wal_anotar(registros, 2);
+    if (lsn == 0)
+    {
+        deshacer_cambio(ranura_destino, &anterior_destino);
+        deshacer_cambio(ranura_origen, &anterior_origen);
+        tabla_desbloquear_par(tabla, num_origen, num_destino);
+        registro_log_general("Transferencia fallida", num_origen, "Anulada por error al escribir el WAL");
+        return OP_ERROR_WAL;
+    }
+
+    // copias para registrar fuera de la seccion critica
+    CuentaBancaria origen = *cuenta_origen;
+    CuentaBancaria destino = *cuenta_destino;
+    tabla_desbloquear_par(tabla, num_origen, num_destino);
+
+    // las ranuras se marcan como sucias fuera de la seccion critica
+    buffer_marcar(ranura_origen);
+    buffer_marcar(ranura_destino);
+
+    *lsn_anotado = lsn;
+    *resultado = origen;
+
+    // Registrar las transacciones
+    registrar_transaccion(TX_TRANSFERENCIA_ENVIADA, origen.numero_cuenta, destino.numero_cuenta, cantidad, origen.saldo);
+    registrar_transaccion(TX_TRANSFERENCIA_RECIBIDA, destino.numero_cuenta, origen.numero_cuenta, cantidad, destino.saldo);
+    registro_log_general("Transferencia realizada", origen.numero_cuenta, "Transferencia realizada por usuario");
+    registro_log_general("Transferencia recibida", destino.numero_cuenta, "Transferencia recibida por usuario");
+    return OP_CORRECTA;
+}
+
+// Variantes que confirman la operacion: vuelven con el WAL ya en disco
+int operacion_depositar(int numero_cuenta, float cantidad, CuentaBancaria *resultado)
+{
+    unsigned long long lsn = 0;
+    int codigo = operacion_depositar_sin_esperar(numero_cuenta, cantidad, resultado, &lsn);
+    wal_esperar(lsn);
+    return codigo;
+}
+
+int operacion_retirar(int numero_cuenta, float cantidad, CuentaBancaria *resultado)
+{
+    unsigned long long lsn = 0;
+    int codigo = operacion_retirar_sin_esperar(numero_cuenta, cantidad, resultado, &lsn);
+    wal_esperar(lsn);
+    return codigo;
+}
+
+int operacion_transferir(int num_origen, int num_destino, float cantidad, CuentaBancaria *resultado)
+{
+    unsigned long long lsn = 0;
+    int codigo = operacion_transferir_sin_esperar(num_origen, num_destino, cantidad, resultado, &lsn);
+    wal_esperar(lsn);
+    return codigo;
+}
+
+// Copia el estado actual de la cuenta sin cerrojo (seqlock),
+// las consultas no bloquean a los retiros, depositos ni transferencias
+// retorno de OP_CORRECTA u OP_CUENTA_NO_EXISTE
+int operacion_consultar(int numero_cuenta, CuentaBancaria *resultado)
+{
+    if (tabla_leer_cuenta(tabla_operaciones, numero_cuenta, resultado) == -1)
+    {
+        registro_log_general("Consulta", numero_cuenta, "Cuenta no encontrada al consultar saldo");
+        return OP_CUENTA_NO_EXISTE;
+    }
+
+    registro_log_general("Consulta", numero_cuenta, "Consulta de saldo realizada");
+    return OP_CORRECTA;
+}
+
+// Comprueba el PIN de la cuenta
+// retorno de OP_CORRECTA, OP_CUENTA_NO_EXISTE u OP_PIN_INCORRECTO
+int operacion_autenticar(int numero_cuenta, int pin, CuentaBancaria *resultado)
+{
+    if (tabla_leer_cuenta(tabla_operaciones, numero_cuenta, resultado) == -1)
+    {
+        registro_log_general("Login", numero_cuenta, "Cuenta no encontrada");
+        return OP_CUENTA_NO_EXISTE;
+    }
+    if (resultado->pin != pin)
+    {
+        registro_log_general("Login", numero_cuenta, "PIN incorrecto");
+        return OP_PIN_INCORRECTO;
+    }
+
+    registro_log_general("Login", numero_cuenta, "Login exitoso");
+    return OP_CORRECTA;
+}
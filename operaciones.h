@@ -0,0 +1,34 @@
+#ifndef OPERACIONES_H
+#define OPERACIONES_H
+
+#include "config.h"
+#include "tabla_cuentas.h"
+
+// Resultado de una operacion
+#define OP_CORRECTA 0
+#define OP_CUENTA_NO_EXISTE -1
+#define OP_FONDOS_INSUFICIENTES -2
+#define OP_LIMITE_EXCEDIDO -3
+#define OP_IMPORTE_NO_VALIDO -4
+#define OP_PIN_INCORRECTO -5
+#define OP_ERROR_WAL -6 // no se pudo anotar en el WAL, la operacion no se ha hecho
+
+void operaciones_iniciar(TablaCuentas *tabla, const Config *config);
+
+int operacion_depositar(int numero_cuenta, float cantidad, CuentaBancaria *resultado);
+int operacion_retirar(int numero_cuenta, float cantidad, CuentaBancaria *resultado);
+int operacion_transferir(int cuenta_origen, int cuenta_destino, float cantidad, CuentaBancaria *resultado);
+// Aplican y anotan en el WAL sin esperar a que llegue a disco: la operacion
+// no esta confirmada hasta wal_esperar(lsn_anotado)
+int operacion_depositar_sin_esperar(int numero_cuenta, float cantidad, CuentaBancaria *resultado,
+                                    unsigned long long *lsn_anotado);
+int operacion_retirar_sin_esperar(int numero_cuenta, float cantidad, CuentaBancaria *resultado,
+                                  unsigned long long *lsn_anotado);
+int operacion_transferir_sin_esperar(int cuenta_origen, int cuenta_destino, float cantidad,
+                                     CuentaBancaria *resultado, unsigned long long *lsn_anotado);
+int operacion_consultar(int numero_cuenta, CuentaBancaria *resultado);
+int operacion_autenticar(int numero_cuenta, int pin, CuentaBancaria *resultado);
+
+const char *operacion_mensaje(int codigo);
+
+#endif
@@ -0,0 +1,305 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "persistencia.h"
+
+// Estado local del proceso sobre cuentas.dat mapeado en memoria
+// El indice (numero de cuenta -> registro) evita recorrer el fichero:
+// cada escritura es una copia directa sobre el registro mapeado
+static int fd_cuentas = -1;
+static CuentaBancaria *mapa = NULL;
+static size_t num_registros = 0;
+static int politica_sync = SINC_NINGUNA;
+
+static int *indice_cuentas = NULL;   // numero de cuenta de cada hueco
+static int *indice_registros = NULL; // registro+1 en el fichero, 0 = hueco libre
+static unsigned int tam_indice = 0;
+static unsigned int ocupados = 0;
+
+static pthread_mutex_t mutex_persistencia = PTHREAD_MUTEX_INITIALIZER;
+
+// Traduce el valor de SINCRONIZACION_CUENTAS a una politica
+int persistencia_politica(const char *nombre)
+{
+    if (strcmp(nombre, "msync") == 0)
+        return SINC_MSYNC;
+    if (strcmp(nombre, "fdatasync") == 0)
+        return SINC_FDATASYNC;
+    return SINC_NINGUNA;
+}
+
+static unsigned int hash_cuenta(int numero_cuenta)
+{
+    return ((unsigned int)numero_cuenta * 2654435761u) & (tam_indice - 1);
+}
+
+static void indice_insertar(int numero_cuenta, size_t registro)
+{
+    unsigned int h = hash_cuenta(numero_cuenta);
+    while (indice_registros[h] != 0)
+    {
+        // con cuentas duplicadas en el fichero gana la primera, como en cargar_cuentas
+        if (indice_cuentas[h] == numero_cuenta)
+            return;
+        h = (h + 1) & (tam_indice - 1);
+    }
+
+    indice_cuentas[h] = numero_cuenta;
+    indice_registros[h] = registro + 1;
+    ocupados++;
+}
+
+// retorno del registro de la cuenta, -1 si no esta en el fichero
+static long indice_buscar(int numero_cuenta)
+{
+    if (tam_indice == 0)
+        return -1;
+
+    unsigned int h = hash_cuenta(numero_cuenta);
+    while (indice_registros[h] != 0)
+    {
+        if (indice_cuentas[h] == numero_cuenta)
+            return indice_registros[h] - 1;
+        h = (h + 1) & (tam_indice - 1);
+    }
+    return -1;
+}
+
+// Reserva un indice con capacidad para al menos el doble de registros
+static int indice_redimensionar(size_t registros)
+{
+    unsigned int tam = 64;
+    while (tam < 2 * registros)
+        tam <<= 1;
+
+    int *cuentas = calloc(tam, sizeof(int));
+    int *registros_nuevos = calloc(tam, sizeof(int));
+    if (!cuentas || !registros_nuevos)
+    {
+        free(cuentas);
+        free(registros_nuevos);
+        return -1;
+    }
+
+    free(indice_cuentas);
+    free(indice_registros);
+    indice_cuentas = cuentas;
+    indice_registros = registros_nuevos;
+    tam_indice = tam;
+    ocupados = 0;
+    return 0;
+}
+
+// Ajusta el mapeo al tamanio actual del fichero e indexa los registros nuevos
+// (otro proceso puede haber aniadido cuentas al final)
+static int actualizar_mapeo()
+{
+    struct stat st;
+    if (fstat(fd_cuentas, &st) == -1)
+    {
+        perror("fstat cuentas.dat");
+        return -1;
+    }
+
+    size_t registros = st.st_size / sizeof(CuentaBancaria);
+    if (registros == num_registros)
+        return 0;
+
+    if (mapa != NULL)
+        munmap(mapa, num_registros * sizeof(CuentaBancaria));
+    mapa = NULL;
+
+    if (registros > 0)
+    {
+        mapa = mmap(NULL, registros * sizeof(CuentaBancaria), PROT_READ | PROT_WRITE, MAP_SHARED, fd_cuentas, 0);
+        if (mapa == MAP_FAILED)
+        {
+            perror("mmap cuentas.dat");
+            mapa = NULL;
+            num_registros = 0;
+            return -1;
+        }
+    }
+
+    size_t desde = num_registros;
+    if (2 * registros > tam_indice)
+    {
+        if (indice_redimensionar(registros) == -1)
+            return -1;
+        desde = 0;
+    }
+
+    for (size_t i = desde; i < registros; i++)
+    {
+        indice_insertar(mapa[i].numero_cuenta, i);
+    }
+
+    num_registros = registros;
+    return 0;
+}
+
+// Abre y mapea el fichero de cuentas, lo crea si no existe
+// retorno de 0 si todo va bien, -1 en caso de error
+int persistencia_abrir(const char *ruta, int politica)
+{
+    fd_cuentas = open(ruta, O_RDWR | O_CREAT, 0666);
+    if (fd_cuentas == -1)
+    {
+        perror("Error al abrir cuentas.dat");
+        return -1;
+    }
+
+    politica_sync = politica;
+
+    pthread_mutex_lock(&mutex_persistencia);
+    int resultado = actualizar_mapeo();
+    pthread_mutex_unlock(&mutex_persistencia);
+
+    return resultado;
+}
+
+void persistencia_cerrar()
+{
+    pthread_mutex_lock(&mutex_persistencia);
+    if (mapa != NULL)
+    {
+        msync(mapa, num_registros * sizeof(CuentaBancaria), MS_SYNC);
+        munmap(mapa, num_registros * sizeof(CuentaBancaria));
+    }
+    if (fd_cuentas != -1)
+        close(fd_cuentas);
+
+    free(indice_cuentas);
+    free(indice_registros);
+    indice_cuentas = NULL;
+    indice_registros = NULL;
+    tam_indice = 0;
+    mapa = NULL;
+    num_registros = 0;
+    fd_cuentas = -1;
+    pthread_mutex_unlock(&mutex_persistencia);
+}
+
+// Vuelca los registros [primero, ultimo] segun la politica de durabilidad
+static void sincronizar_registros(size_t primero, size_t ultimo)
+{
+    if (politica_sync == SINC_MSYNC)
+    {
+        // msync trabaja con paginas completas
+        long pagina = sysconf(_SC_PAGESIZE);
+        uintptr_t inicio = (uintptr_t)&mapa[primero] & ~((uintptr_t)pagina - 1);
+        uintptr_t fin = (uintptr_t)&mapa[ultimo + 1];
+        msync((void *)inicio, fin - inicio, MS_SYNC);
+    }
+    else if (politica_sync == SINC_FDATASYNC)
+    {
+        fdatasync(fd_cuentas);
+    }
+}
+
+// Escribe la cuenta en su registro, con el mutex ya tomado y sin sincronizar
+// retorno del registro escrito, -1 en caso de error
+static long escribir_registro(CuentaBancaria *cuenta)
+{
+    long registro = indice_buscar(cuenta->numero_cuenta);
+    if (registro == -1)
+    {
+        // puede que otro proceso la haya aniadido
+        actualizar_mapeo();
+        registro = indice_buscar(cuenta->numero_cuenta);
+    }
+
+    if (registro == -1)
+    {
+        // cuenta nueva: se aniade al final del fichero
+        if (pwrite(fd_cuentas, cuenta, sizeof(CuentaBancaria), num_registros * sizeof(CuentaBancaria)) != sizeof(CuentaBancaria) ||
+            actualizar_mapeo() == -1)
+            return -1;
+        registro = indice_buscar(cuenta->numero_cuenta);
+    }
+    else
+    {
+        mapa[registro] = *cuenta;
+    }
+    return registro;
+}
+
+// Escribe la cuenta en su registro de cuentas.dat
+// Si la cuenta no esta en el fichero se aniade al final
+// retorno de 0 si se escribe, -1 en caso de error
+int persistencia_escribir(CuentaBancaria cuenta)
+{
+    pthread_mutex_lock(&mutex_persistencia);
+
+    long registro = escribir_registro(&cuenta);
+    if (registro != -1)
+        sincronizar_registros(registro, registro);
+
+    pthread_mutex_unlock(&mutex_persistencia);
+    return registro == -1 ? -1 : 0;
+}
+
+// Escribe un lote de cuentas con una sola toma del mutex y una sola
+// sincronizacion que cubre desde el primer hasta el ultimo registro tocado
+// retorno de 0 si se escriben todas, -1 si alguna falla
+int persistencia_escribir_lote(CuentaBancaria *cuentas, int n)
+{
+    int resultado = 0;
+    long primero = -1, ultimo = -1;
+
+    pthread_mutex_lock(&mutex_persistencia);
+
+    for (int i = 0; i < n; i++)
+    {
+        long registro = escribir_registro(&cuentas[i]);
+        if (registro == -1)
+        {
+            resultado = -1;
+            continue;
+        }
+        if (primero == -1 || registro < primero)
+            primero = registro;
+        if (registro > ultimo)
+            ultimo = registro;
+    }
+
+    if (primero != -1)
+        sincronizar_registros(primero, ultimo);
+
+    pthread_mutex_unlock(&mutex_persistencia);
+    return resultado;
+}
+
+// Copia una cuenta desde cuentas.dat sin recorrer el fichero
+// retorno de 0 si se encuentra, -1 si no
+int persistencia_buscar(int numero_cuenta, CuentaBancaria *copia)
+{
+    pthread_mutex_lock(&mutex_persistencia);
+
+    long registro = indice_buscar(numero_cuenta);
+    if (registro == -1)
+    {
+        actualizar_mapeo();
+        registro = indice_buscar(numero_cuenta);
+    }
+    if (registro != -1)
+        *copia = mapa[registro];
+
+    pthread_mutex_unlock(&mutex_persistencia);
+    return registro == -1 ? -1 : 0;
+}
+
+// Vuelca todo el fichero mapeado a disco
+void persistencia_sincronizar()
+{
+    pthread_mutex_lock(&mutex_persistencia);
+    if (mapa != NULL)
+        msync(mapa, num_registros * sizeof(CuentaBancaria), MS_SYNC);
+    pthread_mutex_unlock(&mutex_persistencia);
+}
@@ -0,0 +1,20 @@
+#ifndef PERSISTENCIA_H
+#define PERSISTENCIA_H
+
+#include "tabla_cuentas.h"
+
+// Politicas de durabilidad de cuentas.dat (SINCRONIZACION_CUENTAS en config.txt)
+#define SINC_NINGUNA 0   // el kernel vuelca las paginas cuando quiere
+#define SINC_MSYNC 1     // msync sincrono de la pagina del registro tras cada escritura
+#define SINC_FDATASYNC 2 // fdatasync del fichero tras cada escritura
+
+int persistencia_politica(const char *nombre);
+int persistencia_abrir(const char *ruta, int politica);
+void persistencia_cerrar();
+
+int persistencia_escribir(CuentaBancaria cuenta);
+int persistencia_escribir_lote(CuentaBancaria *cuentas, int n);
+int persistencia_buscar(int numero_cuenta, CuentaBancaria *copia);
+void persistencia_sincronizar();
+
+#endif
@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pool.h"
+
+static void *hilo_pool(void *arg)
+{
+    PoolHilos *pool = (PoolHilos *)arg;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (1)
+    {
+        while (pool->num_tareas == 0 && !pool->parar)
+            pthread_cond_wait(&pool->hay_tareas, &pool->mutex);
+        if (pool->num_tareas == 0)
+            break; // parar y cola vacia
+
+        Tarea tarea = pool->tareas[pool->primera];
+        pool->primera = (pool->primera + 1) % pool->capacidad;
+        pool->num_tareas--;
+        pthread_cond_signal(&pool->hay_sitio);
+        pthread_mutex_unlock(&pool->mutex);
+
+        tarea.funcion(tarea.arg);
+
+        pthread_mutex_lock(&pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+// Crea el pool y arranca sus hilos
+// retorno del pool, NULL en caso de error
+PoolHilos *pool_crear(int num_hilos, int capacidad)
+{
+    PoolHilos *pool = calloc(1, sizeof(PoolHilos));
+    if (pool == NULL)
+    {
+        perror("calloc pool de hilos");
+        return NULL;
+    }
+    pool->tareas = calloc(capacidad, sizeof(Tarea));
+    pool->hilos = calloc(num_hilos, sizeof(pthread_t));
+    if (pool->tareas == NULL || pool->hilos == NULL)
+    {
+        perror("calloc pool de hilos");
+        free(pool->tareas);
+        free(pool->hilos);
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->hay_tareas, NULL);
+    pthread_cond_init(&pool->hay_sitio, NULL);
+    pool->capacidad = capacidad;
+
+    for (int i = 0; i < num_hilos; i++)
+    {
+        if (pthread_create(&pool->hilos[i], NULL, hilo_pool, pool) != 0)
+        {
+            perror("Error al crear un hilo del pool");
+            break;
+        }
+        pool->num_hilos++;
+    }
+    if (pool->num_hilos == 0)
+    {
+        pool_detener(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+// Encola una tarea; si la cola esta llena espera a que un hilo la libere
+void pool_enviar(PoolHilos *pool, FuncionTarea funcion, void *arg)
+{
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->num_tareas == pool->capacidad)
+        pthread_cond_wait(&pool->hay_sitio, &pool->mutex);
+
+    pool->tareas[(pool->primera + pool->num_tareas) % pool->capacidad] = (Tarea){funcion, arg};
+    pool->num_tareas++;
+    pthread_cond_signal(&pool->hay_tareas);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+// Atiende las tareas que queden en cola, espera a los hilos y libera el pool
+void pool_detener(PoolHilos *pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+    pool->parar = 1;
+    pthread_cond_broadcast(&pool->hay_tareas);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->num_hilos; i++)
+        pthread_join(pool->hilos[i], NULL);
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->hay_tareas);
+    pthread_cond_destroy(&pool->hay_sitio);
+    free(pool->tareas);
+    free(pool->hilos);
+    free(pool);
+}
@@ -0,0 +1,35 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <pthread.h>
+
+typedef void (*FuncionTarea)(void *arg);
+
+typedef struct
+{
+    FuncionTarea funcion;
+    void *arg;
+} Tarea;
+
+// Pool fijo de hilos con una cola circular de tareas de capacidad fija
+// Los hilos se crean una vez y atienden las tareas en orden de llegada;
+// enviar una tarea con la cola llena espera a que haya sitio
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t hay_tareas;
+    pthread_cond_t hay_sitio;
+    Tarea *tareas;
+    int capacidad;
+    int primera;     // posicion de la siguiente tarea a atender
+    int num_tareas;  // tareas en cola
+    int parar;       // se pide a los hilos que terminen al vaciar la cola
+    int num_hilos;
+    pthread_t *hilos;
+} PoolHilos;
+
+PoolHilos *pool_crear(int num_hilos, int capacidad);
+void pool_enviar(PoolHilos *pool, FuncionTarea funcion, void *arg);
+void pool_detener(PoolHilos *pool);
+
+#endif
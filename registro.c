@@ -0,0 +1,463 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include "registro.h"
+#include "memoria.h"
+#include "reloj.h"
+#include "txlog.h"
+#include "historial.h"
+
+#define TAM_LOTE_TEXTO 65536 // bytes que se acumulan antes de cada write()
+
+// Estado local del proceso sobre el anillo
+static AnilloLog *anillo = NULL;
+static pthread_mutex_t mutex_directo = PTHREAD_MUTEX_INITIALIZER;
+
+// Estado del hilo de escritura (solo en el banco)
+static int fd_aplicacion = -1;
+static int fd_transacciones = -1;
+static char lote_aplicacion[TAM_LOTE_TEXTO];
+static char lote_transacciones[TAM_LOTE_TEXTO] __attribute__((aligned(8)));
+static size_t usado_aplicacion = 0;
+static size_t usado_transacciones = 0;
+static time_t marca_cache = -1;
+static char fecha_cache[30];
+
+// Crea el anillo vacio (lo llama el banco antes de escribir ningun log)
+// retorno de 0 si todo va bien, -1 en caso de error
+int registro_crear()
+{
+    anillo = memoria_crear(NOMBRE_SHM_REGISTRO, sizeof(AnilloLog));
+    if (anillo == NULL)
+        return -1;
+
+    for (unsigned long i = 0; i < REGISTRO_CAPACIDAD; i++)
+        anillo->celdas[i].secuencia = i;
+    anillo->pos_encolar = 0;
+    anillo->pos_desencolar = 0;
+    anillo->durmiendo = 0;
+    anillo->parar = 0;
+    anillo->terminado = 0;
+    anillo->vaciado = 0;
+    anillo->escritor = getpid();
+    anillo->esperas_lleno = 0;
+    anillo->perdidas = 0;
+    if (sem_init(&anillo->sem_datos, 1, 0) == -1)
+    {
+        perror("sem_init registro");
+        return -1;
+    }
+    return 0;
+}
+
+static int escritor_vivo()
+{
+    return kill(anillo->escritor, 0) == 0 || errno != ESRCH;
+}
+
+// El proceso que vacia el anillo sigue vivo y no ha terminado
+static int escritor_activo()
+{
+    if (__atomic_load_n(&anillo->terminado, __ATOMIC_ACQUIRE))
+        return 0;
+    return escritor_vivo();
+}
+
+// Adjunta el anillo creado por el banco
+// Si no existe, o es de un banco que ya no esta, los logs se escriben
+// directamente desde este proceso
+// retorno de 0 si todo va bien, -1 en caso de error
+int registro_adjuntar()
+{
+    anillo = memoria_adjuntar(NOMBRE_SHM_REGISTRO, sizeof(AnilloLog));
+    if (anillo != NULL && !escritor_activo())
+    {
+        memoria_liberar(anillo, sizeof(AnilloLog));
+        anillo = NULL;
+    }
+    return anillo == NULL ? -1 : 0;
+}
+
+// Fecha de la marca con el formato de los logs
+// varias lineas seguidas suelen compartir segundo, se reutiliza el texto
+static const char *fecha_de(time_t marca)
+{
+    if (marca != marca_cache)
+    {
+        struct tm tm_info;
+        localtime_r(&marca, &tm_info);
+        strftime(fecha_cache, sizeof(fecha_cache), "%Y-%m-%d %H:%M:%S", &tm_info);
+        marca_cache = marca;
+    }
+    return fecha_cache;
+}
+
+// Da formato a una linea de texto segun su destino
+// retorno de la longitud de la linea
+static int formatear(const RegistroLog *r, char *linea, size_t tam)
+{
+    const char *fecha = fecha_de(r->marca);
+    int n = 0;
+
+    switch (r->destino)
+    {
+    case LOG_BANCO:
+        n = snprintf(linea, tam, "[%s] | Operación: %s | Descripcion: %s\n", fecha, r->tipo, r->texto);
+        break;
+    case LOG_USUARIO:
+        n = snprintf(linea, tam, "[%s] Cuenta: %d | Operación: %s | Descripcion: %s\n",
+                     fecha, r->numero_cuenta, r->tipo, r->texto);
+        break;
+    case LOG_MONITOR:
+        n = snprintf(linea, tam, "[%s] | Tipo: %s | Descripcion: %s\n", fecha, r->tipo, r->texto);
+        break;
+    }
+    return n < (int)tam ? n : (int)tam - 1;
+}
+
+// Escribe todo el bloque aunque write() lo acepte por partes
+static void escribir_todo(int fd, const char *datos, size_t tam)
+{
+    while (tam > 0)
+    {
+        ssize_t escrito = write(fd, datos, tam);
+        if (escrito == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            perror("Error al escribir el log");
+            return;
+        }
+        datos += escrito;
+        tam -= escrito;
+    }
+}
+
+// Registro binario de una transaccion anotada
+static void a_registro_tx(const RegistroLog *r, RegistroTx *tx)
+{
+    memset(tx, 0, sizeof(RegistroTx));
+    tx->marca = r->marca;
+    tx->numero_cuenta = r->numero_cuenta;
+    tx->contraparte = r->contraparte;
+    tx->operacion = r->operacion;
+    tx->monto = r->monto;
+    tx->saldo = r->saldo;
+}
+
+// Escritura sin anillo: abrir, aniadir la linea y cerrar, como una sola llamada
+// el historial por cuenta tiene un unico escritor y sin el banco no se actualiza
+static void escribir_directo(const RegistroLog *r)
+{
+    char ruta[150];
+    char linea[512];
+    RegistroTx tx;
+    const char *datos = linea;
+    int n;
+
+    pthread_mutex_lock(&mutex_directo);
+    if (r->destino == LOG_TRANSACCION)
+    {
+        snprintf(ruta, sizeof(ruta), "%s", TXLOG);
+        a_registro_tx(r, &tx);
+        datos = (const char *)&tx;
+        n = sizeof(RegistroTx);
+    }
+    else
+    {
+        snprintf(ruta, sizeof(ruta), "%s", LOG_APLICACION);
+        n = formatear(r, linea, sizeof(linea));
+    }
+
+    int fd = open(ruta, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd == -1)
+    {
+        perror("Error al abrir el log");
+    }
+    else
+    {
+        escribir_todo(fd, datos, n);
+        close(fd);
+    }
+    pthread_mutex_unlock(&mutex_directo);
+}
+
+// Deja el registro en el anillo
+// No toma cerrojos ni hace llamadas al sistema mientras hay hueco:
+// se reserva una posicion, se copia el registro sin formatear y se publica
+static void encolar(const RegistroLog *r)
+{
+    if (anillo == NULL || __atomic_load_n(&anillo->terminado, __ATOMIC_ACQUIRE))
+    {
+        escribir_directo(r);
+        return;
+    }
+
+    unsigned long pos = __atomic_load_n(&anillo->pos_encolar, __ATOMIC_RELAXED);
+    CeldaLog *celda;
+    while (1)
+    {
+        celda = &anillo->celdas[pos & (REGISTRO_CAPACIDAD - 1)];
+        unsigned long secuencia = __atomic_load_n(&celda->secuencia, __ATOMIC_ACQUIRE);
+        long diferencia = (long)(secuencia - pos);
+
+        if (diferencia == 0)
+        {
+            if (__atomic_compare_exchange_n(&anillo->pos_encolar, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (diferencia < 0)
+        {
+            // anillo lleno: se despierta al escritor y se espera a que libere huecos
+            // si el banco ya no esta nadie los va a liberar y se escribe directamente
+            if (!escritor_activo())
+            {
+                escribir_directo(r);
+                return;
+            }
+            __atomic_fetch_add(&anillo->esperas_lleno, 1, __ATOMIC_RELAXED);
+            sem_post(&anillo->sem_datos);
+            struct timespec espera = {0, 1000000};
+            nanosleep(&espera, NULL);
+            pos = __atomic_load_n(&anillo->pos_encolar, __ATOMIC_RELAXED);
+        }
+        else
+        {
+            pos = __atomic_load_n(&anillo->pos_encolar, __ATOMIC_RELAXED);
+        }
+    }
+
+    // se publica con CAS: si el escritor ya dio la celda por perdida la linea
+    // no se puede dejar en el anillo
+    celda->registro = *r;
+    unsigned long libre = pos;
+    if (!__atomic_compare_exchange_n(&celda->secuencia, &libre, pos + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+    {
+        escribir_directo(r);
+        return;
+    }
+
+    // si el escritor termino mientras se publicaba puede que su ultimo vaciado
+    // no la haya visto: se espera a ese vaciado y, si sigue ahi, se escribe aqui
+    if (__atomic_load_n(&anillo->terminado, __ATOMIC_SEQ_CST))
+    {
+        struct timespec espera = {0, 1000000};
+        while (!__atomic_load_n(&anillo->vaciado, __ATOMIC_ACQUIRE) && escritor_vivo())
+            nanosleep(&espera, NULL);
+        if (__atomic_load_n(&celda->secuencia, __ATOMIC_ACQUIRE) == pos + 1)
+            escribir_directo(r);
+        return;
+    }
+
+    // con el anillo a medias se adelanta el volcado, si no lo hace el temporizador
+    unsigned long ocupacion = pos + 1 - __atomic_load_n(&anillo->pos_desencolar, __ATOMIC_RELAXED);
+    if (ocupacion >= REGISTRO_CAPACIDAD / 2 && __atomic_exchange_n(&anillo->durmiendo, 0, __ATOMIC_ACQ_REL) == 1)
+        sem_post(&anillo->sem_datos);
+}
+
+// Aniade una linea de texto al log de su destino
+void registro_anotar(int destino, int numero_cuenta, const char *tipo, const char *texto, float monto, float saldo)
+{
+    RegistroLog r;
+    r.destino = destino;
+    r.numero_cuenta = numero_cuenta;
+    r.operacion = 0;
+    r.contraparte = 0;
+    r.marca = reloj_ahora();
+    r.monto = monto;
+    r.saldo = saldo;
+    snprintf(r.tipo, sizeof(r.tipo), "%s", tipo);
+    snprintf(r.texto, sizeof(r.texto), "%s", texto ? texto : "");
+
+    encolar(&r);
+}
+
+// Aniade una transaccion al log binario
+void registro_anotar_tx(int operacion, int numero_cuenta, int contraparte, float monto, float saldo)
+{
+    RegistroLog r;
+    r.destino = LOG_TRANSACCION;
+    r.numero_cuenta = numero_cuenta;
+    r.operacion = operacion;
+    r.contraparte = contraparte;
+    r.marca = reloj_ahora();
+    r.monto = monto;
+    r.saldo = saldo;
+    r.tipo[0] = '\0';
+    r.texto[0] = '\0';
+    encolar(&r);
+}
+
+static void vaciar_lotes()
+{
+    if (usado_aplicacion > 0)
+        escribir_todo(fd_aplicacion, lote_aplicacion, usado_aplicacion);
+    if (usado_transacciones > 0)
+        escribir_todo(fd_transacciones, lote_transacciones, usado_transacciones);
+    usado_aplicacion = 0;
+    usado_transacciones = 0;
+    historial_volcar();
+}
+
+// Formatea una linea en el lote de su fichero
+// las transacciones van al lote binario sin formatear y al historial de la cuenta
+static void procesar(const RegistroLog *r)
+{
+    char linea[512];
+    int n;
+
+    if (r->destino == LOG_TRANSACCION)
+    {
+        if (usado_transacciones + sizeof(RegistroTx) > TAM_LOTE_TEXTO)
+            vaciar_lotes();
+        RegistroTx *tx = (RegistroTx *)(lote_transacciones + usado_transacciones);
+        a_registro_tx(r, tx);
+        usado_transacciones += sizeof(RegistroTx);
+        historial_anotar(tx);
+        return;
+    }
+
+    n = formatear(r, linea, sizeof(linea));
+
+    if (usado_aplicacion + n > TAM_LOTE_TEXTO)
+        vaciar_lotes();
+    memcpy(lote_aplicacion + usado_aplicacion, linea, n);
+    usado_aplicacion += n;
+}
+
+static long long ahora_ms()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000LL + t.tv_nsec / 1000000;
+}
+
+// Celda reservada que su productor no publica: si lleva asi mas de
+// REGISTRO_ESPERA_PUBLICAR_MS (el productor murio entre reservar y publicar)
+// se libera para no bloquear el anillo y se anota como perdida
+// retorno de 1 si se ha saltado, 0 si hay que seguir esperando
+static int saltar_celda(CeldaLog *celda, unsigned long pos)
+{
+    static unsigned long pos_atascada = (unsigned long)-1;
+    static long long atascada_desde = 0;
+
+    if (pos != pos_atascada)
+    {
+        pos_atascada = pos;
+        atascada_desde = ahora_ms();
+        return 0;
+    }
+    if (ahora_ms() - atascada_desde < REGISTRO_ESPERA_PUBLICAR_MS)
+        return 0;
+
+    // si el productor publica a la vez gana uno de los dos CAS
+    unsigned long reservada = pos;
+    if (!__atomic_compare_exchange_n(&celda->secuencia, &reservada, pos + REGISTRO_CAPACIDAD, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        return 0;
+
+    __atomic_fetch_add(&anillo->perdidas, 1, __ATOMIC_RELAXED);
+    RegistroLog aviso = {0};
+    aviso.destino = LOG_BANCO;
+    aviso.marca = reloj_ahora();
+    snprintf(aviso.tipo, sizeof(aviso.tipo), "Registro");
+    snprintf(aviso.texto, sizeof(aviso.texto), "Linea de log perdida: un proceso la reservo y no la publico");
+    procesar(&aviso);
+    return 1;
+}
+
+// Saca del anillo todas las lineas publicadas
+// retorno del numero de lineas procesadas
+static int drenar()
+{
+    unsigned long pos = anillo->pos_desencolar;
+    int procesadas = 0;
+
+    while (1)
+    {
+        CeldaLog *celda = &anillo->celdas[pos & (REGISTRO_CAPACIDAD - 1)];
+        if (__atomic_load_n(&celda->secuencia, __ATOMIC_SEQ_CST) != pos + 1)
+        {
+            // vacio, o reservada y aun sin publicar
+            if (pos == __atomic_load_n(&anillo->pos_encolar, __ATOMIC_ACQUIRE) || !saltar_celda(celda, pos))
+                break;
+        }
+        else
+        {
+            procesar(&celda->registro);
+            __atomic_store_n(&celda->secuencia, pos + REGISTRO_CAPACIDAD, __ATOMIC_RELEASE);
+        }
+        pos++;
+        procesadas++;
+        __atomic_store_n(&anillo->pos_desencolar, pos, __ATOMIC_RELEASE);
+    }
+
+    vaciar_lotes();
+    return procesadas;
+}
+
+// Hilo del banco que escribe los logs de todos los procesos
+// Cada vuelta vuelca lo acumulado y duerme como mucho REGISTRO_LATENCIA_MS
+void *registro_hilo_escritura(void *arg)
+{
+    (void)arg;
+    fd_aplicacion = open(LOG_APLICACION, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    fd_transacciones = open(TXLOG, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd_aplicacion == -1 || fd_transacciones == -1)
+    {
+        perror("Error al abrir los logs");
+        return NULL;
+    }
+    if (historial_abrir(DIR_HISTORIAL, 1) == -1)
+    {
+        fprintf(stderr, "Historial por cuenta no disponible\n");
+    }
+
+    while (1)
+    {
+        if (drenar() > 0)
+            continue;
+        if (__atomic_load_n(&anillo->parar, __ATOMIC_ACQUIRE))
+            break;
+
+        __atomic_store_n(&anillo->durmiendo, 1, __ATOMIC_SEQ_CST);
+        struct timespec limite;
+        clock_gettime(CLOCK_REALTIME, &limite);
+        limite.tv_nsec += REGISTRO_LATENCIA_MS * 1000000L;
+        if (limite.tv_nsec >= 1000000000L)
+        {
+            limite.tv_sec++;
+            limite.tv_nsec -= 1000000000L;
+        }
+        sem_timedwait(&anillo->sem_datos, &limite);
+        __atomic_store_n(&anillo->durmiendo, 0, __ATOMIC_RELEASE);
+    }
+
+    // desde aqui las lineas de todos los procesos se escriben directamente;
+    // se vacia otra vez por las que se publicaron mientras se marcaba el final
+    drenar();
+    __atomic_store_n(&anillo->terminado, 1, __ATOMIC_SEQ_CST);
+    drenar();
+    __atomic_store_n(&anillo->vaciado, 1, __ATOMIC_RELEASE);
+    anillo = NULL;
+    close(fd_aplicacion);
+    close(fd_transacciones);
+    historial_cerrar();
+    return NULL;
+}
+
+// Pide al hilo de escritura que vuelque lo pendiente y termine
+// El anillo deja de poder adjuntarse: los procesos que arranquen sin el banco
+// escriben sus logs directamente
+void registro_detener()
+{
+    shm_unlink(NOMBRE_SHM_REGISTRO);
+    __atomic_store_n(&anillo->parar, 1, __ATOMIC_RELEASE);
+    sem_post(&anillo->sem_datos);
+}
@@ -0,0 +1,70 @@
+#ifndef REGISTRO_H
+#define REGISTRO_H
+
+#include <time.h>
+#include <semaphore.h>
+#include <sys/types.h>
+
+#define NOMBRE_SHM_REGISTRO "/secure_bank_registro" // Anillo compartido de lineas de log
+#define REGISTRO_CAPACIDAD 4096                      // entradas del anillo (potencia de 2)
+#define REGISTRO_LATENCIA_MS 50                      // tiempo maximo de una linea en el anillo
+#define REGISTRO_ESPERA_PUBLICAR_MS 1000             // celda reservada sin publicar que se da por perdida
+#define LOG_APLICACION "application.log"
+
+// Destino y formato de cada linea
+#define LOG_BANCO 0       // application.log, eventos del banco
+#define LOG_USUARIO 1     // application.log, eventos de un usuario (con cuenta)
+#define LOG_MONITOR 2     // application.log, eventos del monitor
+#define LOG_TRANSACCION 3 // transacciones.bin (RegistroTx) y el historial de la cuenta
+
+// Linea de log sin formatear, de tamanio fijo
+typedef struct
+{
+    int destino;
+    int numero_cuenta;
+    int operacion;   // codigo TX_* de las transacciones
+    int contraparte; // otra cuenta de una transferencia
+    time_t marca;
+    float monto;
+    float saldo;
+    char tipo[48];
+    char texto[160];
+} RegistroLog;
+
+// Hueco del anillo: la secuencia indica si esta libre para el productor de la
+// vuelta actual (igual a la posicion) o lista para el escritor (posicion+1)
+typedef struct
+{
+    unsigned long secuencia;
+    RegistroLog registro;
+} CeldaLog;
+
+// Cola sin cerrojos de muchos productores (banco, usuarios, monitor) y un unico
+// consumidor, el hilo de escritura del banco, que formatea las lineas y las
+// aniade por lotes a ficheros que mantiene abiertos; tambien es el unico
+// escritor del historial por cuenta
+typedef struct
+{
+    unsigned long pos_encolar;    // siguiente posicion que reservan los productores
+    unsigned long pos_desencolar; // siguiente posicion que lee el escritor
+    int durmiendo;                // el escritor espera en sem_datos
+    int parar;                    // el banco pide al escritor que termine
+    int terminado;                // el escritor ya no vacia el anillo
+    int vaciado;                  // el escritor ha hecho su ultimo vaciado
+    pid_t escritor;               // proceso del banco que vacia el anillo
+    sem_t sem_datos;              // despierta al escritor antes de que venza la latencia
+    unsigned long esperas_lleno;  // veces que un productor encontro el anillo lleno
+    unsigned long perdidas;       // celdas reservadas que su productor no llego a publicar
+    CeldaLog celdas[REGISTRO_CAPACIDAD];
+} AnilloLog;
+
+int registro_crear();
+int registro_adjuntar();
+
+void registro_anotar(int destino, int numero_cuenta, const char *tipo, const char *texto, float monto, float saldo);
+void registro_anotar_tx(int operacion, int numero_cuenta, int contraparte, float monto, float saldo);
+
+void *registro_hilo_escritura(void *arg);
+void registro_detener();
+
+#endif
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <string.h>
+#include "reglas.h"
+
+// Nombres de las operaciones en el fichero de reglas
+static const char *nombres_operacion[MAX_OPERACION + 1] = {
+    [TX_DEPOSITO] = "deposito",
+    [TX_RETIRO] = "retiro",
+    [TX_TRANSFERENCIA_ENVIADA] = "transferencia",
+    [TX_TRANSFERENCIA_RECIBIDA] = "recepcion",
+};
+
+// Operaciones en plural para los mensajes de alerta
+static const char *descripciones_operacion[MAX_OPERACION + 1] = {
+    [TX_DEPOSITO] = "depositos",
+    [TX_RETIRO] = "retiros",
+    [TX_TRANSFERENCIA_ENVIADA] = "transferencias",
+    [TX_TRANSFERENCIA_RECIBIDA] = "transferencias recibidas",
+};
+
+const char *reglas_descripcion_operacion(int operacion)
+{
+    if (operacion < 1 || operacion > MAX_OPERACION)
+        return "operaciones";
+    return descripciones_operacion[operacion];
+}
+
+static int operacion_de(const char *nombre)
+{
+    for (int op = 1; op <= MAX_OPERACION; op++)
+    {
+        if (strcmp(nombre, nombres_operacion[op]) == 0)
+            return op;
+    }
+    return -1;
+}
+
+// Ordena las reglas por operacion (conservando el orden del fichero), rellena
+// la tabla de despacho desde[] y asigna a cada regla su ranura de estado
+static void compilar(TablaReglas *tabla, Regla *leidas, int n)
+{
+    int k = 0;
+    tabla->num_cuenta = 0;
+    tabla->num_global = 0;
+    for (int op = 0; op <= MAX_OPERACION; op++)
+    {
+        tabla->desde[op] = k;
+        for (int i = 0; i < n; i++)
+        {
+            if (leidas[i].operacion != op)
+                continue;
+            Regla *r = &tabla->reglas[k++];
+            *r = leidas[i];
+            r->ranura = r->ambito == AMBITO_GLOBAL ? tabla->num_global++ : tabla->num_cuenta++;
+        }
+    }
+    tabla->desde[MAX_OPERACION + 1] = k;
+    tabla->num_reglas = k;
+}
+
+// Lee las reglas de deteccion de un fichero de texto, una por linea:
+//   nombre operacion ambito ventana operaciones importe
+// Las lineas mal formadas se ignoran avisando por stderr
+// retorno del numero de reglas cargadas, -1 si no se puede abrir el fichero
+int reglas_cargar(const char *ruta, TablaReglas *tabla)
+{
+    FILE *archivo = fopen(ruta, "r");
+    if (archivo == NULL)
+    {
+        perror("Error al abrir el fichero de reglas");
+        return -1;
+    }
+
+    Regla leidas[MAX_REGLAS];
+    int n = 0;
+    int num_linea = 0;
+    char linea[200];
+    while (fgets(linea, sizeof(linea), archivo))
+    {
+        num_linea++;
+        if (linea[0] == '#' || linea[0] == '\n')
+            continue;
+
+        Regla r = {0};
+        char operacion[32], ambito[16];
+        if (sscanf(linea, "%31s %31s %15s %d %d %f", r.nombre, operacion, ambito, &r.ventana,
+                   &r.min_operaciones, &r.min_importe) != 6)
+        {
+            fprintf(stderr, "%s:%d: regla incompleta\n", ruta, num_linea);
+            continue;
+        }
+
+        r.operacion = operacion_de(operacion);
+        if (strcmp(ambito, "cuenta") == 0)
+            r.ambito = AMBITO_CUENTA;
+        else if (strcmp(ambito, "global") == 0)
+            r.ambito = AMBITO_GLOBAL;
+        else
+            r.ambito = -1;
+
+        if (r.operacion == -1 || r.ambito == -1 || r.ventana <= 0 || r.min_operaciones < 0 ||
+            r.min_importe < 0 || (r.min_operaciones == 0 && r.min_importe == 0))
+        {
+            fprintf(stderr, "%s:%d: regla no valida\n", ruta, num_linea);
+            continue;
+        }
+        if (n == MAX_REGLAS)
+        {
+            fprintf(stderr, "%s:%d: demasiadas reglas, maximo %d\n", ruta, num_linea, MAX_REGLAS);
+            break;
+        }
+        leidas[n++] = r;
+    }
+    fclose(archivo);
+
+    compilar(tabla, leidas, n);
+    return n;
+}
+
+// Reglas equivalentes a UMBRAL_RETIROS y UMBRAL_TRANSFERENCIAS de config.txt,
+// para cuando no hay fichero de reglas
+void reglas_por_defecto(TablaReglas *tabla, int ventana, int umbral_retiros, int umbral_transferencias)
+{
+    Regla leidas[2] = {
+        {"retiro", TX_RETIRO, AMBITO_CUENTA, ventana, umbral_retiros, 0, 0},
+        {"transferencia", TX_TRANSFERENCIA_ENVIADA, AMBITO_CUENTA, ventana, umbral_transferencias, 0, 0},
+    };
+    compilar(tabla, leidas, 2);
+}
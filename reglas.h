@@ -0,0 +1,41 @@
+#ifndef REGLAS_H
+#define REGLAS_H
+
+#include "txlog.h"
+
+#define MAX_REGLAS 32                           // reglas de deteccion cargadas a la vez
+#define MAX_OPERACION TX_TRANSFERENCIA_RECIBIDA // mayor codigo TX_* que puede tener una regla
+
+// Ambito de una regla
+#define AMBITO_CUENTA 0 // se cuentan las operaciones de cada cuenta por separado
+#define AMBITO_GLOBAL 1 // se cuentan las operaciones de todo el banco
+
+// Regla de deteccion: salta cuando dentro de la ventana se alcanzan a la vez
+// el numero de operaciones y el importe indicados (un umbral a 0 no se comprueba)
+typedef struct
+{
+    char nombre[32];
+    int operacion;       // TX_*
+    int ambito;          // AMBITO_*
+    int ventana;         // segundos
+    int min_operaciones;
+    float min_importe;
+    int ranura;          // posicion del estado de la regla dentro de su ambito
+} Regla;
+
+// Reglas compiladas: ordenadas por operacion, las de la operacion op son
+// reglas[desde[op]] .. reglas[desde[op + 1] - 1]
+typedef struct
+{
+    int num_reglas;
+    int num_cuenta; // reglas con AMBITO_CUENTA
+    int num_global; // reglas con AMBITO_GLOBAL
+    int desde[MAX_OPERACION + 2];
+    Regla reglas[MAX_REGLAS];
+} TablaReglas;
+
+int reglas_cargar(const char *ruta, TablaReglas *tabla);
+void reglas_por_defecto(TablaReglas *tabla, int ventana, int umbral_retiros, int umbral_transferencias);
+const char *reglas_descripcion_operacion(int operacion);
+
+#endif
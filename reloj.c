@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "reloj.h"
+
+#define ESPERA_SONDEO_VIRTUAL_NS 10000000L // espera real minima de un sondeo en modo virtual (10 ms)
+#define ESPERAS_CREACION 1000             // esperas de 1 ms a que otro proceso inicie el reloj
+
+// Estado local del proceso sobre el reloj
+// Sin memoria compartida el reloj virtual es solo de este proceso
+static int modo_reloj = RELOJ_DEMO;
+static RelojVirtual reloj_local;
+static RelojVirtual *reloj = &reloj_local;
+
+static long long monotonico_ns()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static void reloj_empezar(RelojVirtual *r)
+{
+    r->inicio = time(NULL);
+    r->inicio_monotonico = monotonico_ns();
+    r->segundos_saltados = 0;
+}
+
+// Crea el reloj compartido o adjunta el que creo otro proceso
+// El reloj sobrevive a los procesos: la hora virtual sigue avanzando entre
+// reinicios del banco, y los checkpoints del monitor siguen siendo comparables
+// retorno del reloj, NULL si no se puede compartir
+static RelojVirtual *reloj_compartido()
+{
+    int creado = 1;
+    int fd = shm_open(NOMBRE_SHM_RELOJ, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd == -1 && errno == EEXIST)
+    {
+        creado = 0;
+        fd = shm_open(NOMBRE_SHM_RELOJ, O_RDWR, 0666);
+    }
+    if (fd == -1 || (creado && ftruncate(fd, sizeof(RelojVirtual)) == -1))
+    {
+        perror("shm_open reloj virtual");
+        if (fd != -1)
+            close(fd);
+        return NULL;
+    }
+
+    // quien lo crea puede no haber fijado aun el tamanio
+    struct stat st;
+    for (int i = 0; i < ESPERAS_CREACION && fstat(fd, &st) == 0 && (size_t)st.st_size < sizeof(RelojVirtual); i++)
+    {
+        struct timespec espera = {0, 1000000};
+        nanosleep(&espera, NULL);
+    }
+    RelojVirtual *r = mmap(NULL, sizeof(RelojVirtual), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (r == MAP_FAILED || (size_t)st.st_size < sizeof(RelojVirtual))
+    {
+        perror("mmap reloj virtual");
+        return NULL;
+    }
+
+    if (creado)
+    {
+        reloj_empezar(r);
+        __atomic_store_n(&r->listo, 1, __ATOMIC_RELEASE);
+        return r;
+    }
+    for (int i = 0; i < ESPERAS_CREACION && !__atomic_load_n(&r->listo, __ATOMIC_ACQUIRE); i++)
+    {
+        struct timespec espera = {0, 1000000};
+        nanosleep(&espera, NULL);
+    }
+    if (!__atomic_load_n(&r->listo, __ATOMIC_ACQUIRE))
+    {
+        munmap(r, sizeof(RelojVirtual));
+        return NULL;
+    }
+    return r;
+}
+
+// Traduce el valor de MODO_RELOJ a un modo del reloj
+// sin valor se mantiene el ritmo de demostracion
+int reloj_modo(const char *nombre)
+{
+    if (strcmp(nombre, "real") == 0)
+        return RELOJ_REAL;
+    if (strcmp(nombre, "virtual") == 0)
+        return RELOJ_VIRTUAL;
+    return RELOJ_DEMO;
+}
+
+void reloj_iniciar(int modo)
+{
+    modo_reloj = modo;
+    reloj_empezar(&reloj_local);
+    reloj = &reloj_local;
+    if (modo == RELOJ_VIRTUAL)
+    {
+        RelojVirtual *compartido = reloj_compartido();
+        if (compartido != NULL)
+            reloj = compartido;
+    }
+}
+
+// Espera entre los mensajes de la interfaz y los pasos de cada operacion
+// Solo se duerme en modo demo, en virtual solo avanza la hora
+void pausa(int segundos)
+{
+    if (modo_reloj == RELOJ_DEMO)
+    {
+        struct timespec espera = {segundos, 0};
+        nanosleep(&espera, NULL);
+    }
+    else if (modo_reloj == RELOJ_VIRTUAL)
+    {
+        __atomic_fetch_add(&reloj->segundos_saltados, segundos, __ATOMIC_RELAXED);
+    }
+}
+
+// Espera entre dos sondeos de un fichero o recurso
+// Siempre duerme algo para no ocupar la CPU; en virtual la espera real es minima
+void pausa_sondeo(int segundos)
+{
+    struct timespec espera = {segundos, 0};
+    if (modo_reloj == RELOJ_VIRTUAL)
+    {
+        __atomic_fetch_add(&reloj->segundos_saltados, segundos, __ATOMIC_RELAXED);
+        espera.tv_sec = 0;
+        espera.tv_nsec = ESPERA_SONDEO_VIRTUAL_NS;
+    }
+    nanosleep(&espera, NULL);
+}
+
+// Hora para las marcas de los logs
+time_t reloj_ahora()
+{
+    if (modo_reloj == RELOJ_VIRTUAL)
+        return reloj->inicio + (monotonico_ns() - reloj->inicio_monotonico) / 1000000000LL +
+               __atomic_load_n(&reloj->segundos_saltados, __ATOMIC_RELAXED);
+    return time(NULL);
+}
@@ -0,0 +1,31 @@
+#ifndef RELOJ_H
+#define RELOJ_H
+
+#include <time.h>
+
+// Modos del reloj (MODO_RELOJ en config.txt)
+#define RELOJ_REAL 0    // hora del sistema y sin pausas de demostracion
+#define RELOJ_DEMO 1    // hora del sistema y pausas de demostracion (comportamiento original)
+#define RELOJ_VIRTUAL 2 // sin esperas, la hora avanza lo que dura cada pausa
+
+#define NOMBRE_SHM_RELOJ "/secure_bank_reloj" // Reloj virtual comun a todos los procesos
+
+// Reloj virtual: la hora avanza con el tiempo real transcurrido mas lo que
+// se han saltado las pausas de todos los procesos, asi es monotona y la misma
+// en el banco, los usuarios y el monitor aunque nadie haga pausas
+typedef struct
+{
+    int listo;                   // el proceso que lo crea ya lo ha iniciado
+    time_t inicio;               // hora del sistema al crearlo
+    long long inicio_monotonico; // CLOCK_MONOTONIC en ns al crearlo
+    long segundos_saltados;      // suma de las pausas no dormidas
+} RelojVirtual;
+
+int reloj_modo(const char *nombre);
+void reloj_iniciar(int modo);
+
+void pausa(int segundos);
+void pausa_sondeo(int segundos);
+time_t reloj_ahora();
+
+#endif
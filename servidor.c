@@ -0,0 +1,520 @@
+#define _GNU_SOURCE // accept4
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "servidor.h"
+#include "operaciones.h"
+#include "wal.h"
+#include "registro.h"
+#include "pool.h"
+
+// Servidor de sesiones del banco: un hilo espera con epoll a todos los
+// clientes conectados al socket Unix y pasa las sesiones con datos al pool
+// de hilos, que ejecuta sus operaciones con operaciones.c sin esperar al WAL.
+// La sesion queda aparcada con sus respuestas hasta que un hilo de
+// confirmacion ve en disco el lsn de la ultima: una sola espera confirma a
+// todas las sesiones aparcadas y los hilos del pool nunca se bloquean en el
+// WAL. Abrir una sesion es aceptar una conexion y reservar su estructura,
+// sin crear procesos, hilos ni terminales
+
+// Estado local del servidor
+static volatile sig_atomic_t parar_servidor = 0;
+static int epoll_servidor = -1;
+
+// Sesiones abiertas, para cerrar las que siguen conectadas al terminar
+// Se aniaden en el hilo de epoll y se quitan en los hilos del pool
+static pthread_mutex_t mutex_sesiones = PTHREAD_MUTEX_INITIALIZER;
+static Sesion *sesiones = NULL;
+static int sesiones_abiertas = 0;
+
+// Sesiones con respuestas que esperan al WAL, las atiende hilo_confirmacion
+static PoolHilos *pool_servidor = NULL;
+static pthread_mutex_t mutex_confirmar = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t hay_confirmaciones = PTHREAD_COND_INITIALIZER;
+static Sesion *por_confirmar = NULL;
+static int parar_confirmacion = 0;
+static pthread_t hilo_confirmar;
+
+static void manejar_senal(int sig)
+{
+    (void)sig;
+    parar_servidor = 1;
+}
+
+static void registro_log_general(const char *tipo, const char *descripcion)
+{
+    registro_anotar(LOG_BANCO, 0, tipo, descripcion, 0, 0);
+}
+
+// Aniade una respuesta a la salida de la sesion
+// Si el cliente no lee y la salida se llena, la sesion se cierra
+static void responder(Sesion *sesion, const char *formato, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static void responder(Sesion *sesion, const char *formato, ...)
+{
+    va_list argumentos;
+    va_start(argumentos, formato);
+    size_t libre = TAM_SALIDA_SESION - sesion->usado_salida;
+    int n = vsnprintf(sesion->salida + sesion->usado_salida, libre, formato, argumentos);
+    va_end(argumentos);
+
+    if (n < 0 || (size_t)n >= libre)
+    {
+        sesion->cerrar = 1;
+        return;
+    }
+    sesion->usado_salida += n;
+}
+
+// La respuesta de una operacion anotada en lsn no sale antes de que el WAL este en disco
+static void responder_resultado(Sesion *sesion, int resultado, const CuentaBancaria *cuenta, unsigned long long lsn)
+{
+    if (lsn > sesion->lsn_pendiente)
+        sesion->lsn_pendiente = lsn;
+    if (resultado == OP_CORRECTA)
+        responder(sesion, "OK %.2f\n", cuenta->saldo);
+    else
+        responder(sesion, "ERROR %s\n", operacion_mensaje(resultado));
+}
+
+// Ejecuta una peticion de la sesion
+static void atender_linea(Sesion *sesion, char *linea)
+{
+    char orden[16];
+    int entero, pin;
+    float cantidad;
+    CuentaBancaria cuenta;
+    unsigned long long lsn = 0;
+
+    if (sscanf(linea, "%15s", orden) != 1)
+        return;
+
+    if (strcmp(orden, "SALIR") == 0)
+    {
+        responder(sesion, "OK adios\n");
+        sesion->cerrar = 1;
+        return;
+    }
+
+    if (strcmp(orden, "LOGIN") == 0)
+    {
+        if (sscanf(linea, "%*s %d %d", &entero, &pin) != 2)
+        {
+            responder(sesion, "ERROR Uso: LOGIN <cuenta> <pin>\n");
+            return;
+        }
+        int resultado = operacion_autenticar(entero, pin, &cuenta);
+        if (resultado == OP_CORRECTA)
+        {
+            sesion->numero_cuenta = entero;
+            responder(sesion, "OK %.2f %s\n", cuenta.saldo, cuenta.titular);
+        }
+        else if (++sesion->intentos >= INTENTOS_LOGIN)
+        {
+            responder(sesion, "ERROR Demasiados intentos\n");
+            sesion->cerrar = 1;
+        }
+        else
+        {
+            responder(sesion, "ERROR %s\n", operacion_mensaje(resultado));
+        }
+        return;
+    }
+
+    if (sesion->numero_cuenta == 0)
+    {
+        responder(sesion, "ERROR Sesion sin autenticar\n");
+        return;
+    }
+
+    if (strcmp(orden, "DEPOSITAR") == 0 && sscanf(linea, "%*s %f", &cantidad) == 1)
+    {
+        int resultado = operacion_depositar_sin_esperar(sesion->numero_cuenta, cantidad, &cuenta, &lsn);
+        responder_resultado(sesion, resultado, &cuenta, lsn);
+    }
+    else if (strcmp(orden, "RETIRAR") == 0 && sscanf(linea, "%*s %f", &cantidad) == 1)
+    {
+        int resultado = operacion_retirar_sin_esperar(sesion->numero_cuenta, cantidad, &cuenta, &lsn);
+        responder_resultado(sesion, resultado, &cuenta, lsn);
+    }
+    else if (strcmp(orden, "TRANSFERIR") == 0 && sscanf(linea, "%*s %d %f", &entero, &cantidad) == 2)
+    {
+        int resultado = operacion_transferir_sin_esperar(sesion->numero_cuenta, entero, cantidad, &cuenta, &lsn);
+        responder_resultado(sesion, resultado, &cuenta, lsn);
+    }
+    else if (strcmp(orden, "SALDO") == 0)
+    {
+        int resultado = operacion_consultar(sesion->numero_cuenta, &cuenta);
+        if (resultado == OP_CORRECTA)
+            responder(sesion, "OK %.2f %d %s\n", cuenta.saldo, cuenta.num_transacciones, cuenta.titular);
+        else
+            responder(sesion, "ERROR %s\n", operacion_mensaje(resultado));
+    }
+    else
+    {
+        responder(sesion, "ERROR Peticion no valida\n");
+    }
+}
+
+static void anotar_sesion(Sesion *sesion)
+{
+    pthread_mutex_lock(&mutex_sesiones);
+    sesion->anterior = NULL;
+    sesion->siguiente = sesiones;
+    if (sesiones != NULL)
+        sesiones->anterior = sesion;
+    sesiones = sesion;
+    sesiones_abiertas++;
+    pthread_mutex_unlock(&mutex_sesiones);
+}
+
+static void cerrar_sesion(Sesion *sesion)
+{
+    pthread_mutex_lock(&mutex_sesiones);
+    if (sesion->anterior != NULL)
+        sesion->anterior->siguiente = sesion->siguiente;
+    else
+        sesiones = sesion->siguiente;
+    if (sesion->siguiente != NULL)
+        sesion->siguiente->anterior = sesion->anterior;
+    sesiones_abiertas--;
+    pthread_mutex_unlock(&mutex_sesiones);
+
+    epoll_ctl(epoll_servidor, EPOLL_CTL_DEL, sesion->fd, NULL);
+    close(sesion->fd);
+    free(sesion);
+}
+
+// Hay sitio en la salida para la respuesta mas larga
+static int salida_libre(const Sesion *sesion)
+{
+    return sesion->usado_salida + RESERVA_RESPUESTA <= TAM_SALIDA_SESION;
+}
+
+// Atiende las lineas completas de la entrada mientras quepan sus respuestas;
+// un cliente que encadena peticiones sin leer las respuestas se frena aqui
+static void procesar_entrada(Sesion *sesion)
+{
+    char *inicio = sesion->entrada;
+    char *fin;
+    while (!sesion->cerrar && salida_libre(sesion) &&
+           (fin = memchr(inicio, '\n', sesion->usado_entrada - (inicio - sesion->entrada))) != NULL)
+    {
+        *fin = '\0';
+        atender_linea(sesion, inicio);
+        inicio = fin + 1;
+    }
+    sesion->usado_entrada -= inicio - sesion->entrada;
+    memmove(sesion->entrada, inicio, sesion->usado_entrada);
+
+    if (sesion->usado_entrada == TAM_LINEA_SESION && memchr(sesion->entrada, '\n', TAM_LINEA_SESION) == NULL)
+    {
+        responder(sesion, "ERROR Linea demasiado larga\n");
+        sesion->cerrar = 1;
+    }
+}
+
+// Lee lo que haya llegado y atiende las lineas completas
+static void leer_sesion(Sesion *sesion)
+{
+    while (!sesion->cerrar && salida_libre(sesion) && sesion->usado_entrada < TAM_LINEA_SESION)
+    {
+        ssize_t n = recv(sesion->fd, sesion->entrada + sesion->usado_entrada,
+                         TAM_LINEA_SESION - sesion->usado_entrada, MSG_DONTWAIT);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n <= 0)
+        {
+            // el cliente ha cerrado: se descarta lo pendiente
+            sesion->usado_salida = 0;
+            sesion->cerrar = 1;
+            break;
+        }
+        sesion->usado_entrada += n;
+        procesar_entrada(sesion);
+    }
+}
+
+// Envia lo pendiente sin bloquear; lo que no cabe en el socket espera a EPOLLOUT
+// retorno de 0 si todo va bien, -1 si la conexion ya no sirve
+static int enviar_salida(Sesion *sesion)
+{
+    size_t enviado = 0;
+    while (enviado < sesion->usado_salida)
+    {
+        ssize_t n = send(sesion->fd, sesion->salida + enviado, sesion->usado_salida - enviado,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n <= 0)
+            return -1;
+        enviado += n;
+    }
+    memmove(sesion->salida, sesion->salida + enviado, sesion->usado_salida - enviado);
+    sesion->usado_salida -= enviado;
+    return 0;
+}
+
+// Deja la sesion esperando al WAL; sigue siendo solo del servidor hasta que
+// hilo_confirmacion la devuelve al pool
+static void aparcar_sesion(Sesion *sesion)
+{
+    pthread_mutex_lock(&mutex_confirmar);
+    sesion->siguiente_confirmar = por_confirmar;
+    por_confirmar = sesion;
+    pthread_cond_signal(&hay_confirmaciones);
+    pthread_mutex_unlock(&mutex_confirmar);
+}
+
+// Atiende los avisos de epoll de una sesion en un hilo del pool
+// Con EPOLLONESHOT la sesion es solo de este hilo hasta que se rearma al final;
+// mientras la salida esta llena no se leen mas peticiones de la sesion
+static void atender_sesion(void *arg)
+{
+    Sesion *sesion = (Sesion *)arg;
+
+    if ((sesion->eventos & (EPOLLERR | EPOLLHUP)) && !(sesion->eventos & EPOLLIN))
+    {
+        cerrar_sesion(sesion);
+        return;
+    }
+
+    if (sesion->eventos & EPOLLIN)
+    {
+        leer_sesion(sesion);
+    }
+    else
+    {
+        // se vacia la salida y se atienden las peticiones que esperaban en la entrada
+        if (enviar_salida(sesion) == -1)
+        {
+            cerrar_sesion(sesion);
+            return;
+        }
+        procesar_entrada(sesion);
+    }
+
+    // con respuestas sin confirmar el hilo queda libre y la sesion se aparca
+    if (sesion->lsn_pendiente != 0)
+    {
+        aparcar_sesion(sesion);
+        return;
+    }
+
+    if (enviar_salida(sesion) == -1 || (sesion->cerrar && sesion->usado_salida == 0))
+    {
+        cerrar_sesion(sesion);
+        return;
+    }
+
+    struct epoll_event evento = {EPOLLONESHOT | (salida_libre(sesion) ? EPOLLIN : 0) |
+                                     (sesion->usado_salida > 0 ? EPOLLOUT : 0),
+                                 {.ptr = sesion}};
+    epoll_ctl(epoll_servidor, EPOLL_CTL_MOD, sesion->fd, &evento);
+}
+
+// Hilo que confirma las respuestas aparcadas: toma todas las sesiones que
+// esperan, hace una espera al WAL por el lsn mas alto y las devuelve al pool
+// para que envien sus respuestas; las que se aparcan mientras tanto van en la
+// siguiente vuelta, asi que cada espera cubre el commit de muchas sesiones
+static void *hilo_confirmacion(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&mutex_confirmar);
+    while (1)
+    {
+        while (por_confirmar == NULL && !parar_confirmacion)
+            pthread_cond_wait(&hay_confirmaciones, &mutex_confirmar);
+        if (por_confirmar == NULL)
+            break;
+        Sesion *lista = por_confirmar;
+        por_confirmar = NULL;
+        pthread_mutex_unlock(&mutex_confirmar);
+
+        unsigned long long lsn_maximo = 0;
+        for (Sesion *s = lista; s != NULL; s = s->siguiente_confirmar)
+        {
+            if (s->lsn_pendiente > lsn_maximo)
+                lsn_maximo = s->lsn_pendiente;
+        }
+        wal_esperar(lsn_maximo);
+
+        while (lista != NULL)
+        {
+            Sesion *sesion = lista;
+            lista = lista->siguiente_confirmar;
+            sesion->lsn_pendiente = 0;
+            sesion->eventos = EPOLLOUT; // enviar lo confirmado y seguir con la entrada
+            pool_enviar(pool_servidor, atender_sesion, sesion);
+        }
+        pthread_mutex_lock(&mutex_confirmar);
+    }
+    pthread_mutex_unlock(&mutex_confirmar);
+    return NULL;
+}
+
+// Acepta todas las conexiones pendientes
+static void aceptar_sesiones(int fd_escucha)
+{
+    int fd;
+    while ((fd = accept4(fd_escucha, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+    {
+        Sesion *sesion = calloc(1, sizeof(Sesion));
+        if (sesion == NULL)
+        {
+            close(fd);
+            continue;
+        }
+        sesion->fd = fd;
+        anotar_sesion(sesion); // antes de epoll: desde ahi un hilo del pool puede cerrarla
+
+        struct epoll_event evento = {EPOLLIN | EPOLLONESHOT, {.ptr = sesion}};
+        if (epoll_ctl(epoll_servidor, EPOLL_CTL_ADD, fd, &evento) == -1)
+        {
+            perror("epoll_ctl");
+            cerrar_sesion(sesion);
+            continue;
+        }
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        perror("accept4");
+}
+
+// Socket Unix no bloqueante en ruta
+// retorno del descriptor, -1 en caso de error
+static int abrir_socket(const char *ruta)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+    {
+        perror("socket");
+        return -1;
+    }
+
+    struct sockaddr_un direccion = {0};
+    direccion.sun_family = AF_UNIX;
+    strncpy(direccion.sun_path, ruta, sizeof(direccion.sun_path) - 1);
+    unlink(ruta);
+
+    if (bind(fd, (struct sockaddr *)&direccion, sizeof(direccion)) == -1 || listen(fd, SOMAXCONN) == -1)
+    {
+        perror("Error al abrir el socket del servidor");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Bucle del servidor de sesiones, vuelve al recibir SIGINT o SIGTERM
+// Las operaciones deben estar iniciadas (operaciones_iniciar) antes
+// retorno de 0 al terminar, -1 si no se puede abrir el socket
+int servidor_ejecutar(const char *ruta, PoolHilos *pool)
+{
+    int fd_escucha = abrir_socket(ruta);
+    if (fd_escucha == -1)
+        return -1;
+
+    epoll_servidor = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event evento = {EPOLLIN, {.ptr = NULL}};
+    if (epoll_servidor == -1 || epoll_ctl(epoll_servidor, EPOLL_CTL_ADD, fd_escucha, &evento) == -1)
+    {
+        perror("epoll");
+        close(fd_escucha);
+        return -1;
+    }
+
+    pool_servidor = pool;
+    parar_confirmacion = 0;
+    if (pthread_create(&hilo_confirmar, NULL, hilo_confirmacion, NULL) != 0)
+    {
+        fprintf(stderr, "No se puede crear el hilo de confirmacion\n");
+        close(fd_escucha);
+        return -1;
+    }
+
+    struct sigaction accion = {0};
+    accion.sa_handler = manejar_senal;
+    sigaction(SIGINT, &accion, NULL);
+    sigaction(SIGTERM, &accion, NULL);
+
+    printf("Servidor de sesiones escuchando en %s\n", ruta);
+    registro_log_general("Servidor", "Servidor de sesiones iniciado");
+
+    struct epoll_event eventos[MAX_EVENTOS_EPOLL];
+    while (!parar_servidor)
+    {
+        // con espera limitada: la senal puede llegar a otro hilo del banco
+        int n = epoll_wait(epoll_servidor, eventos, MAX_EVENTOS_EPOLL, 1000);
+        for (int i = 0; i < n; i++)
+        {
+            Sesion *sesion = eventos[i].data.ptr;
+            if (sesion == NULL)
+            {
+                aceptar_sesiones(fd_escucha);
+            }
+            else
+            {
+                sesion->eventos = eventos[i].events;
+                pool_enviar(pool, atender_sesion, sesion);
+            }
+        }
+    }
+
+    // el hilo de confirmacion termina su vuelta antes de que se detenga el pool;
+    // lo que se aparque despues lo confirma servidor_cerrar_sesiones
+    pthread_mutex_lock(&mutex_confirmar);
+    parar_confirmacion = 1;
+    pthread_cond_signal(&hay_confirmaciones);
+    pthread_mutex_unlock(&mutex_confirmar);
+    pthread_join(hilo_confirmar, NULL);
+
+    pthread_mutex_lock(&mutex_sesiones);
+    int abiertas = sesiones_abiertas;
+    pthread_mutex_unlock(&mutex_sesiones);
+    char mensaje[80];
+    snprintf(mensaje, sizeof(mensaje), "Servidor detenido con %d sesiones abiertas", abiertas);
+    registro_log_general("Servidor", mensaje);
+    close(fd_escucha);
+    unlink(ruta);
+    return 0;
+}
+
+// Cierra las sesiones que siguen conectadas y el epoll del servidor
+// Se llama con el pool ya detenido: las tareas en cola se han atendido y
+// ningun hilo usa ya las sesiones. Las respuestas aparcadas se confirman con
+// una ultima espera al WAL y lo pendiente se intenta enviar sin esperar
+void servidor_cerrar_sesiones()
+{
+    unsigned long long lsn_maximo = 0;
+    for (Sesion *s = sesiones; s != NULL; s = s->siguiente)
+    {
+        if (s->lsn_pendiente > lsn_maximo)
+            lsn_maximo = s->lsn_pendiente;
+    }
+    wal_esperar(lsn_maximo);
+    por_confirmar = NULL;
+
+    while (sesiones != NULL)
+    {
+        enviar_salida(sesiones);
+        cerrar_sesion(sesiones);
+    }
+    if (epoll_servidor != -1)
+    {
+        close(epoll_servidor);
+        epoll_servidor = -1;
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef SERVIDOR_H
+#define SERVIDOR_H
+
+#include <stddef.h>
+#include "pool.h"
+
+#define SOCKET_BANCO "banco.sock" // Socket Unix del servidor de sesiones
+#define TAM_LINEA_SESION 256      // linea de peticion mas larga que se acepta
+#define TAM_SALIDA_SESION 4096    // respuestas pendientes de enviar por sesion
+#define RESERVA_RESPUESTA 256     // sitio libre en la salida para atender otra peticion
+#define MAX_EVENTOS_EPOLL 256     // eventos que se atienden por vuelta del bucle
+#define INTENTOS_LOGIN 3
+#define MAX_SESIONES_COLA 4096    // sesiones con datos esperando un hilo del pool
+
+// Sesion de un cliente conectado al servidor
+// Protocolo de lineas de texto, una peticion por linea:
+//   LOGIN <cuenta> <pin>             -> OK <saldo> <titular>
+//   DEPOSITAR <cantidad>             -> OK <saldo>
+//   RETIRAR <cantidad>               -> OK <saldo>
+//   TRANSFERIR <destino> <cantidad>  -> OK <saldo>
+//   SALDO                            -> OK <saldo> <transacciones> <titular>
+//   SALIR                            -> OK adios (y se cierra la sesion)
+// Los errores se responden como ERROR <mensaje>
+typedef struct Sesion
+{
+    int fd;
+    int numero_cuenta; // 0 hasta que se autentica
+    int intentos;      // intentos de login fallidos
+    int cerrar;        // se cierra al terminar de enviar las respuestas
+    unsigned int eventos; // avisos de epoll que debe atender el hilo del pool
+    unsigned long long lsn_pendiente; // las respuestas no salen hasta que el WAL llega aqui
+    size_t usado_entrada;
+    size_t usado_salida;
+    char entrada[TAM_LINEA_SESION];
+    char salida[TAM_SALIDA_SESION];
+    struct Sesion *anterior; // lista de sesiones abiertas
+    struct Sesion *siguiente;
+    struct Sesion *siguiente_confirmar; // cola de sesiones que esperan al WAL
+} Sesion;
+
+int servidor_ejecutar(const char *ruta, PoolHilos *pool);
+void servidor_cerrar_sesiones();
+
+#endif
@@ -0,0 +1,402 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "tabla_cuentas.h"
+
+#define ALINEACION_GRANDE (2 * 1024 * 1024) // Tamanio de pagina grande para alinear la region
+#define TAM_PAGINA 4096
+#define ESPERAS_SECUENCIA 1000 // esperas con la secuencia impar antes de pedir el cerrojo de la franja
+
+// Estado local del proceso sobre la region compartida
+static int fd_tabla = -1;
+static char *base_reserva = NULL;
+static size_t tam_reserva = 0;
+
+// Desplazamiento del indice dentro de la region para una capacidad dada
+static size_t offset_indice(int capacidad)
+{
+    return sizeof(TablaCuentas) + (size_t)capacidad * sizeof(RanuraCuenta);
+}
+
+// Huecos del indice: la potencia de 2 mayor o igual al doble de la capacidad
+static unsigned int calcular_tam_indice(int capacidad)
+{
+    unsigned int tam = 1;
+    while (tam < 2u * (unsigned int)capacidad)
+        tam <<= 1;
+    return tam;
+}
+
+// Bytes totales de la region para una capacidad dada, redondeados a pagina
+static size_t calcular_tam_total(int capacidad)
+{
+    size_t tam = offset_indice(capacidad) + calcular_tam_indice(capacidad) * sizeof(int);
+    return (tam + TAM_PAGINA - 1) & ~((size_t)TAM_PAGINA - 1);
+}
+
+static int *indice_de(TablaCuentas *tabla, int capacidad)
+{
+    return (int *)((char *)tabla + offset_indice(capacidad));
+}
+
+// Funcion hash multiplicativa sobre el numero de cuenta
+// devuelve el hueco inicial dentro del indice
+static unsigned int hash_cuenta(int numero_cuenta, unsigned int tam_indice)
+{
+    return ((unsigned int)numero_cuenta * 2654435761u) & (tam_indice - 1);
+}
+
+// Mapea los tam bytes del objeto shm alineados a pagina grande
+// retorno de la direccion de la tabla, NULL en caso de error
+static TablaCuentas *mapear_region(size_t tam, int paginas_grandes)
+{
+    tam_reserva = tam + ALINEACION_GRANDE;
+    base_reserva = mmap(NULL, tam_reserva, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base_reserva == MAP_FAILED)
+    {
+        perror("mmap reserva de la tabla de cuentas");
+        base_reserva = NULL;
+        return NULL;
+    }
+
+    // alinear a pagina grande para que el kernel pueda usar huge pages
+    char *inicio = (char *)(((uintptr_t)base_reserva + ALINEACION_GRANDE - 1) & ~((uintptr_t)ALINEACION_GRANDE - 1));
+
+    if (mmap(inicio, tam, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd_tabla, 0) == MAP_FAILED)
+    {
+        perror("mmap tabla de cuentas");
+        munmap(base_reserva, tam_reserva);
+        base_reserva = NULL;
+        return NULL;
+    }
+
+    if (paginas_grandes)
+        madvise(inicio, tam, MADV_HUGEPAGE);
+
+    return (TablaCuentas *)inicio;
+}
+
+// Crea la region compartida de la tabla (la llama el banco al arrancar)
+// como parametro se pasa la capacidad inicial y si se piden paginas grandes
+TablaCuentas *tabla_crear(int capacidad, int paginas_grandes)
+{
+    if (capacidad < CAPACIDAD_MINIMA)
+        capacidad = CAPACIDAD_MINIMA;
+    if (capacidad > CAPACIDAD_MAXIMA)
+        capacidad = CAPACIDAD_MAXIMA;
+
+    // se descarta una tabla anterior, las cuentas se recargan desde cuentas.dat
+    shm_unlink(NOMBRE_SHM_TABLA);
+    fd_tabla = shm_open(NOMBRE_SHM_TABLA, O_CREAT | O_RDWR, 0666);
+    if (fd_tabla == -1)
+    {
+        perror("shm_open tabla de cuentas");
+        return NULL;
+    }
+
+    size_t tam = calcular_tam_total(capacidad);
+    if (ftruncate(fd_tabla, tam) == -1)
+    {
+        perror("ftruncate tabla de cuentas");
+        close(fd_tabla);
+        fd_tabla = -1;
+        return NULL;
+    }
+
+    TablaCuentas *tabla = mapear_region(tam, paginas_grandes);
+    if (tabla == NULL)
+    {
+        close(fd_tabla);
+        fd_tabla = -1;
+        return NULL;
+    }
+
+    // cerrojos por franjas visibles para todos los procesos que adjunten la tabla
+    for (int i = 0; i < NUM_FRANJAS; i++)
+    {
+        cerrojo_init(&tabla->franjas[i]);
+    }
+
+    tabla->capacidad = capacidad;
+    tabla->num_cuentas = 0;
+    tabla->tam_indice = calcular_tam_indice(capacidad);
+    tabla->paginas_grandes = paginas_grandes;
+    tabla->tam_total = tam;
+
+    return tabla;
+}
+
+// Adjunta la tabla creada por el banco (usuario, monitor)
+// retorno de NULL si el banco no ha creado la tabla
+TablaCuentas *tabla_adjuntar()
+{
+    fd_tabla = shm_open(NOMBRE_SHM_TABLA, O_RDWR, 0666);
+    if (fd_tabla == -1)
+    {
+        perror("shm_open tabla de cuentas");
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd_tabla, &st) == -1 || (size_t)st.st_size < sizeof(TablaCuentas))
+    {
+        perror("fstat tabla de cuentas");
+        close(fd_tabla);
+        fd_tabla = -1;
+        return NULL;
+    }
+
+    TablaCuentas *tabla = mapear_region(st.st_size, 0);
+    if (tabla == NULL)
+    {
+        close(fd_tabla);
+        fd_tabla = -1;
+        return NULL;
+    }
+
+    if (tabla->paginas_grandes)
+        madvise(tabla, st.st_size, MADV_HUGEPAGE);
+
+    return tabla;
+}
+
+// Libera la reserva de direcciones y el descriptor de la tabla
+void tabla_desadjuntar(TablaCuentas *tabla)
+{
+    (void)tabla;
+    if (base_reserva != NULL)
+        munmap(base_reserva, tam_reserva);
+    if (fd_tabla != -1)
+        close(fd_tabla);
+
+    base_reserva = NULL;
+    fd_tabla = -1;
+}
+
+// Inserta la posicion de una cuenta ya copiada en ranuras[] dentro del indice
+// retorno de 0 si se inserta, -1 si el numero de cuenta ya estaba indexado
+static int indice_insertar(TablaCuentas *tabla, int posicion)
+{
+    int *indice = indice_de(tabla, tabla->capacidad);
+    unsigned int mascara = tabla->tam_indice - 1;
+    int numero_cuenta = tabla->ranuras[posicion].cuenta.numero_cuenta;
+    unsigned int h = hash_cuenta(numero_cuenta, tabla->tam_indice);
+
+    // sondeo lineal hasta encontrar un hueco libre
+    while (indice[h] != 0)
+    {
+        if (tabla->ranuras[indice[h] - 1].cuenta.numero_cuenta == numero_cuenta)
+            return -1;
+        h = (h + 1) & mascara;
+    }
+
+    // publicar la entrada cuando la cuenta ya esta escrita en la tabla
+    __atomic_store_n(&indice[h], posicion + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Reconstruye el indice completo a partir de las cuentas cargadas
+void indice_construir(TablaCuentas *tabla)
+{
+    memset(indice_de(tabla, tabla->capacidad), 0, tabla->tam_indice * sizeof(int));
+
+    for (int i = 0; i < tabla->num_cuentas; i++)
+    {
+        if (indice_insertar(tabla, i) == -1)
+        {
+            printf("Cuenta duplicada en la tabla: %d\n", tabla->ranuras[i].cuenta.numero_cuenta);
+        }
+    }
+}
+
+// Aniade una cuenta al final de la tabla y la registra en el indice
+// retorno de la posicion de la cuenta, -1 si no cabe o la cuenta ya existe
+int tabla_agregar_cuenta(TablaCuentas *tabla, CuentaBancaria cuenta)
+{
+    if (tabla_buscar_posicion(tabla, cuenta.numero_cuenta) != -1)
+        return -1;
+
+    if (tabla->num_cuentas >= tabla->capacidad)
+        return -1;
+
+    int posicion = tabla->num_cuentas;
+    tabla->ranuras[posicion].secuencia = 0;
+    tabla->ranuras[posicion].sucia = 0;
+    tabla->ranuras[posicion].siguiente_sucia = 0;
+    tabla->ranuras[posicion].cuenta = cuenta;
+    indice_insertar(tabla, posicion);
+    __atomic_store_n(&tabla->num_cuentas, posicion + 1, __ATOMIC_RELEASE);
+
+    return posicion;
+}
+
+// Busqueda de la posicion de una cuenta en ranuras[] mediante el indice
+// retorno de la posicion, -1 si la cuenta no existe
+int tabla_buscar_posicion(TablaCuentas *tabla, int numero_cuenta)
+{
+    int *indice = indice_de(tabla, tabla->capacidad);
+    unsigned int mascara = tabla->tam_indice - 1;
+    unsigned int h = hash_cuenta(numero_cuenta, tabla->tam_indice);
+
+    for (unsigned int sondeos = 0; sondeos < tabla->tam_indice; sondeos++)
+    {
+        int entrada = __atomic_load_n(&indice[h], __ATOMIC_ACQUIRE);
+        if (entrada == 0)
+            break;
+        if (tabla->ranuras[entrada - 1].cuenta.numero_cuenta == numero_cuenta)
+            return entrada - 1;
+        h = (h + 1) & mascara;
+    }
+    return -1;
+}
+
+// Devuelve un puntero a la ranura de la cuenta dentro de la tabla, NULL si no existe
+// Para modificar la cuenta hay que tener bloqueada su franja y marcar la escritura en la ranura
+RanuraCuenta *tabla_buscar_ranura(TablaCuentas *tabla, int numero_cuenta)
+{
+    int posicion = tabla_buscar_posicion(tabla, numero_cuenta);
+    if (posicion == -1)
+        return NULL;
+
+    return &tabla->ranuras[posicion];
+}
+
+// Franja a la que pertenece una cuenta
+static unsigned int franja_de(int numero_cuenta)
+{
+    return ((unsigned int)numero_cuenta * 2654435761u >> 16) & (NUM_FRANJAS - 1);
+}
+
+static void franja_bloquear(TablaCuentas *tabla, unsigned int franja);
+
+// Copia consistente de la cuenta de una posicion sin tomar ningun cerrojo
+// Se repite la copia si un escritor la ha modificado mientras tanto
+// Si la secuencia sigue impar demasiado tiempo el escritor puede haber muerto:
+// se copia con la franja bloqueada, que repara la secuencia
+void tabla_leer_posicion(TablaCuentas *tabla, int posicion, CuentaBancaria *copia)
+{
+    RanuraCuenta *ranura = &tabla->ranuras[posicion];
+    unsigned int secuencia;
+    int esperas = 0;
+
+    while (1)
+    {
+        secuencia = __atomic_load_n(&ranura->secuencia, __ATOMIC_ACQUIRE);
+        if (secuencia & 1)
+        {
+            if (++esperas < ESPERAS_SECUENCIA)
+            {
+                sched_yield();
+                continue;
+            }
+            int numero_cuenta = ranura->cuenta.numero_cuenta;
+            franja_bloquear(tabla, franja_de(numero_cuenta));
+            if (ranura->secuencia & 1)
+                ranura_fin_escritura(ranura);
+            memcpy(copia, &ranura->cuenta, sizeof(CuentaBancaria));
+            cerrojo_desbloquear(&tabla->franjas[franja_de(numero_cuenta)]);
+            return;
+        }
+
+        memcpy(copia, &ranura->cuenta, sizeof(CuentaBancaria));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&ranura->secuencia, __ATOMIC_RELAXED) == secuencia)
+            return;
+    }
+}
+
+// Copia consistente de una cuenta buscada por numero
+// retorno de 0 si la cuenta existe, -1 si no
+int tabla_leer_cuenta(TablaCuentas *tabla, int numero_cuenta, CuentaBancaria *copia)
+{
+    int posicion = tabla_buscar_posicion(tabla, numero_cuenta);
+    if (posicion == -1)
+        return -1;
+
+    tabla_leer_posicion(tabla, posicion, copia);
+    return 0;
+}
+
+// Marca el inicio de una modificacion de la cuenta (secuencia impar)
+void ranura_inicio_escritura(RanuraCuenta *ranura)
+{
+    __atomic_store_n(&ranura->secuencia, ranura->secuencia + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+// Marca el fin de la modificacion (secuencia par de nuevo)
+void ranura_fin_escritura(RanuraCuenta *ranura)
+{
+    __atomic_store_n(&ranura->secuencia, ranura->secuencia + 1, __ATOMIC_RELEASE);
+}
+
+// Bloquea una franja
+// Con la franja bloqueada ningun escritor vivo esta a mitad de una cuenta, asi que
+// una secuencia impar es de un proceso que murio entre ranura_inicio_escritura y
+// ranura_fin_escritura: se deja par para que los lectores no esperen para siempre.
+// Solo se recorren las cuentas si hace falta (cerrojo recuperado o lector atascado)
+static void franja_bloquear(TablaCuentas *tabla, unsigned int franja)
+{
+    if (cerrojo_bloquear(&tabla->franjas[franja]) == 0)
+        return;
+
+    int num_cuentas = __atomic_load_n(&tabla->num_cuentas, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < num_cuentas; i++)
+    {
+        RanuraCuenta *ranura = &tabla->ranuras[i];
+        if (franja_de(ranura->cuenta.numero_cuenta) == franja && (ranura->secuencia & 1))
+            ranura_fin_escritura(ranura);
+    }
+}
+
+// Bloquea la franja de una cuenta antes de modificar su saldo
+void tabla_bloquear_cuenta(TablaCuentas *tabla, int numero_cuenta)
+{
+    franja_bloquear(tabla, franja_de(numero_cuenta));
+}
+
+void tabla_desbloquear_cuenta(TablaCuentas *tabla, int numero_cuenta)
+{
+    cerrojo_desbloquear(&tabla->franjas[franja_de(numero_cuenta)]);
+}
+
+// Bloquea las franjas de dos cuentas para una transferencia
+// Se adquieren siempre en orden creciente de franja, asi dos transferencias
+// cruzadas no pueden interbloquearse. Si comparten franja se bloquea una vez
+void tabla_bloquear_par(TablaCuentas *tabla, int cuenta_a, int cuenta_b)
+{
+    unsigned int franja_a = franja_de(cuenta_a);
+    unsigned int franja_b = franja_de(cuenta_b);
+
+    if (franja_a == franja_b)
+    {
+        franja_bloquear(tabla, franja_a);
+        return;
+    }
+
+    if (franja_a > franja_b)
+    {
+        unsigned int aux = franja_a;
+        franja_a = franja_b;
+        franja_b = aux;
+    }
+
+    franja_bloquear(tabla, franja_a);
+    franja_bloquear(tabla, franja_b);
+}
+
+void tabla_desbloquear_par(TablaCuentas *tabla, int cuenta_a, int cuenta_b)
+{
+    unsigned int franja_a = franja_de(cuenta_a);
+    unsigned int franja_b = franja_de(cuenta_b);
+
+    cerrojo_desbloquear(&tabla->franjas[franja_a]);
+    if (franja_b != franja_a)
+        cerrojo_desbloquear(&tabla->franjas[franja_b]);
+}
@@ -0,0 +1,73 @@
+#ifndef TABLA_CUENTAS_H
+#define TABLA_CUENTAS_H
+
+#include <stddef.h>
+#include "cerrojo.h"
+
+#define NOMBRE_SHM_TABLA "/secure_bank_cuentas" // Objeto POSIX shm con la tabla de cuentas
+#define CAPACIDAD_MINIMA 128                     // Capacidad inicial minima de la tabla
+#define CAPACIDAD_MAXIMA (1 << 24)               // Maximo de cuentas
+#define NUM_FRANJAS 1024                         // Cerrojos por franjas de cuentas (potencia de 2)
+
+// Estructura para representar la cuenta bancaria de un usuario
+typedef struct
+{
+    int numero_cuenta;
+    char titular[100];
+    float saldo;
+    int pin;
+    int num_transacciones;
+    int bloqueado;
+} CuentaBancaria;
+
+// Hueco de la tabla compartida: la cuenta y su contador de secuencia (seqlock)
+// El escritor, con la franja bloqueada, deja la secuencia impar mientras
+// modifica la cuenta; los lectores copian sin bloquear y repiten la copia
+// si la secuencia era impar o ha cambiado
+// sucia y siguiente_sucia enlazan la ranura en la pila de escritura diferida
+typedef struct
+{
+    unsigned int secuencia;
+    int sucia;           // 1 si esta pendiente de escribirse en cuentas.dat
+    int siguiente_sucia; // posicion+1 de la siguiente ranura pendiente, 0 = fin
+    CuentaBancaria cuenta;
+} RanuraCuenta;
+
+// Cabecera de la tabla de cuentas en memoria compartida
+// La region contiene: cabecera | ranuras[capacidad] | indice[tam_indice]
+// El indice es una tabla hash de direccionamiento abierto (sondeo lineal)
+// que guarda la posicion+1 de cada cuenta en ranuras[], 0 indica hueco libre.
+// El banco la dimensiona al arrancar con las cuentas de cuentas.dat y no crece
+// despues: no hay altas de cuentas en linea.
+// Cada cuenta se protege con el cerrojo de su franja (hash del numero de cuenta)
+typedef struct
+{
+    int capacidad;           // huecos disponibles en ranuras[]
+    int num_cuentas;         // cuentas cargadas
+    unsigned int tam_indice; // huecos del indice (potencia de 2)
+    int paginas_grandes;     // se pide al kernel respaldar la region con huge pages
+    size_t tam_total;        // bytes de la region compartida
+    Cerrojo franjas[NUM_FRANJAS]; // cerrojos robustos compartidos entre procesos
+    RanuraCuenta ranuras[];
+} TablaCuentas;
+
+TablaCuentas *tabla_crear(int capacidad, int paginas_grandes);
+TablaCuentas *tabla_adjuntar();
+void tabla_desadjuntar(TablaCuentas *tabla);
+
+void indice_construir(TablaCuentas *tabla);
+int tabla_agregar_cuenta(TablaCuentas *tabla, CuentaBancaria cuenta);
+int tabla_buscar_posicion(TablaCuentas *tabla, int numero_cuenta);
+RanuraCuenta *tabla_buscar_ranura(TablaCuentas *tabla, int numero_cuenta);
+int tabla_leer_cuenta(TablaCuentas *tabla, int numero_cuenta, CuentaBancaria *copia);
+void tabla_leer_posicion(TablaCuentas *tabla, int posicion, CuentaBancaria *copia);
+
+void ranura_inicio_escritura(RanuraCuenta *ranura);
+void ranura_fin_escritura(RanuraCuenta *ranura);
+
+void tabla_bloquear_cuenta(TablaCuentas *tabla, int numero_cuenta);
+void tabla_desbloquear_cuenta(TablaCuentas *tabla, int numero_cuenta);
+void tabla_bloquear_par(TablaCuentas *tabla, int cuenta_a, int cuenta_b);
+void tabla_desbloquear_par(TablaCuentas *tabla, int cuenta_a, int cuenta_b);
+
+#endif
@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include <time.h>
+#include "txlog.h"
+
+// Nombre de la operacion tal y como aparecia en transacciones.log
+const char *txlog_nombre_operacion(int operacion)
+{
+    switch (operacion)
+    {
+    case TX_DEPOSITO:
+        return "Depósito";
+    case TX_RETIRO:
+        return "Retiro";
+    case TX_TRANSFERENCIA_ENVIADA:
+        return "Transferencia realizada";
+    case TX_TRANSFERENCIA_RECIBIDA:
+        return "Transferencia recibida";
+    }
+    return "Desconocida";
+}
+
+// Linea de texto de un registro con el formato clasico de transacciones.log
+// retorno de la longitud de la linea
+int txlog_formatear(const RegistroTx *registro, char *linea, size_t tam)
+{
+    time_t marca = (time_t)registro->marca;
+    struct tm tm_info;
+    char fecha_hora[30];
+    localtime_r(&marca, &tm_info);
+    strftime(fecha_hora, sizeof(fecha_hora), "%Y-%m-%d %H:%M:%S", &tm_info);
+
+    int n = snprintf(linea, tam, "[%s] Cuenta: %d | Operación: %s | Monto: %.2f | Saldo final: %.2f\n",
+                     fecha_hora, registro->numero_cuenta, txlog_nombre_operacion(registro->operacion),
+                     registro->monto, registro->saldo);
+    return n < (int)tam ? n : (int)tam - 1;
+}
@@ -0,0 +1,29 @@
+#ifndef TXLOG_H
+#define TXLOG_H
+
+#include <stddef.h>
+
+#define TXLOG "transacciones.bin" // Log binario de transacciones
+
+// Codigos de operacion del log de transacciones
+#define TX_DEPOSITO 1
+#define TX_RETIRO 2
+#define TX_TRANSFERENCIA_ENVIADA 3
+#define TX_TRANSFERENCIA_RECIBIDA 4
+
+// Registro de tamanio fijo de una transaccion
+// Los consumidores leen el fichero como un array de registros, sin analizar texto
+typedef struct
+{
+    long long marca;   // segundos desde epoch
+    int numero_cuenta;
+    int contraparte;   // otra cuenta de una transferencia, 0 si no hay
+    int operacion;     // TX_*
+    float monto;
+    float saldo;       // saldo resultante de la cuenta
+} RegistroTx;
+
+const char *txlog_nombre_operacion(int operacion);
+int txlog_formatear(const RegistroTx *registro, char *linea, size_t tam);
+
+#endif
@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "txlog.h"
+
+#define REGISTROS_LECTURA 4096 // registros que se leen de una vez
+
+// Herramienta que muestra el log binario de transacciones como texto
+// Uso: txlog-dump [fichero]   (por defecto transacciones.bin)
+int main(int argc, char *argv[])
+{
+    const char *ruta = argc > 1 ? argv[1] : TXLOG;
+
+    FILE *archivo = fopen(ruta, "rb");
+    if (!archivo)
+    {
+        perror("Error al abrir el log de transacciones");
+        exit(1);
+    }
+
+    RegistroTx *registros = malloc(REGISTROS_LECTURA * sizeof(RegistroTx));
+    if (registros == NULL)
+    {
+        perror("malloc");
+        exit(1);
+    }
+
+    size_t leidos;
+    char linea[256];
+    while ((leidos = fread(registros, sizeof(RegistroTx), REGISTROS_LECTURA, archivo)) > 0)
+    {
+        for (size_t i = 0; i < leidos; i++)
+        {
+            txlog_formatear(&registros[i], linea, sizeof(linea));
+            fputs(linea, stdout);
+        }
+    }
+
+    free(registros);
+    fclose(archivo);
+    return 0;
+}
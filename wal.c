@@ -0,0 +1,407 @@
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include "wal.h"
+#include "memoria.h"
+#include "persistencia.h"
+
+#define LOTE_PUNTO_CONTROL 256 // cuentas por escritura en el punto de control
+
+// Estado local del proceso sobre el WAL
+static int fd_wal = -1;
+static int modo_wal = WAL_GRUPO;
+static EstadoWal *estado_wal = NULL;
+static const char *ruta_wal = NULL;
+static unsigned long generacion_wal = 0; // generacion del fichero abierto en fd_wal
+
+// Traduce el valor de DURABILIDAD a un modo del WAL
+int wal_modo(const char *nombre)
+{
+    if (strcmp(nombre, "sincrona") == 0)
+        return WAL_SINCRONO;
+    if (strcmp(nombre, "asincrona") == 0)
+        return WAL_ASINCRONO;
+    return WAL_GRUPO;
+}
+
+// Suma de control FNV-1a de todos los campos del registro menos la propia suma
+static unsigned int suma_registro(const RegistroWal *registro)
+{
+    const unsigned char *bytes = (const unsigned char *)registro;
+    unsigned int suma = 2166136261u;
+
+    for (size_t i = 0; i < offsetof(RegistroWal, suma); i++)
+    {
+        suma ^= bytes[i];
+        suma *= 16777619u;
+    }
+    return suma;
+}
+
+// Crea el estado compartido del commit en grupo (lo llama el banco al arrancar)
+// retorno de 0 si todo va bien, -1 en caso de error
+int wal_crear_estado()
+{
+    estado_wal = memoria_crear(NOMBRE_SHM_WAL, sizeof(EstadoWal));
+    if (estado_wal == NULL)
+        return -1;
+
+    cerrojo_init(&estado_wal->cerrojo);
+    condicion_init(&estado_wal->condicion);
+    estado_wal->lsn_siguiente = 1;
+    estado_wal->lsn_durable = 0;
+    estado_wal->sincronizando = 0;
+    estado_wal->pid_lider = 0;
+    estado_wal->generacion = 0;
+    return 0;
+}
+
+// Abre el WAL para aniadir registros y adjunta el estado compartido
+// retorno de 0 si todo va bien, -1 en caso de error
+int wal_abrir(const char *ruta, int modo)
+{
+    if (estado_wal == NULL)
+    {
+        estado_wal = memoria_adjuntar(NOMBRE_SHM_WAL, sizeof(EstadoWal));
+        if (estado_wal == NULL)
+            return -1;
+    }
+
+    // la generacion se lee antes de abrir: si se rota entre medias solo
+    // cuesta una reapertura de mas
+    generacion_wal = __atomic_load_n(&estado_wal->generacion, __ATOMIC_ACQUIRE);
+    fd_wal = open(ruta, O_WRONLY | O_APPEND | O_CREAT, 0666);
+    if (fd_wal == -1)
+    {
+        perror("Error al abrir cuentas.wal");
+        return -1;
+    }
+
+    ruta_wal = ruta;
+    modo_wal = modo;
+    return 0;
+}
+
+void wal_cerrar()
+{
+    if (fd_wal != -1)
+        close(fd_wal);
+    memoria_liberar(estado_wal, sizeof(EstadoWal));
+    fd_wal = -1;
+    estado_wal = NULL;
+}
+
+// Rellena un registro con el estado de la cuenta tras aplicar delta
+void wal_preparar(RegistroWal *registro, const CuentaBancaria *cuenta, float delta)
+{
+    memset(registro, 0, sizeof(RegistroWal));
+    registro->numero_cuenta = cuenta->numero_cuenta;
+    registro->delta = delta;
+    registro->saldo = cuenta->saldo;
+    registro->num_transacciones = cuenta->num_transacciones;
+}
+
+// Si el banco ha rotado el WAL se reabre para escribir en el fichero nuevo
+// Se llama con el cerrojo del WAL
+// retorno de 0 si todo va bien, -1 si no se puede reabrir
+static int seguir_rotacion()
+{
+    if (generacion_wal == estado_wal->generacion)
+        return 0;
+
+    int fd = open(ruta_wal, O_WRONLY | O_APPEND | O_CREAT, 0666);
+    if (fd == -1)
+    {
+        perror("Error al reabrir cuentas.wal");
+        return -1;
+    }
+    close(fd_wal);
+    fd_wal = fd;
+    generacion_wal = estado_wal->generacion;
+    return 0;
+}
+
+// Aniade los registros de una operacion al WAL con una sola escritura
+// Se llama con la franja de las cuentas bloqueada para que el orden del
+// fichero coincida con el orden de los cambios en memoria
+// Si la escritura falla no queda nada en el fichero: se recorta lo que se
+// hubiera escrito a medias, la recuperacion no tiene que saltar una cola rota
+// retorno del lsn del ultimo registro, 0 en caso de error
+unsigned long long wal_anotar(RegistroWal *registros, int num_registros)
+{
+    cerrojo_bloquear(&estado_wal->cerrojo);
+    if (seguir_rotacion() == -1)
+    {
+        cerrojo_desbloquear(&estado_wal->cerrojo);
+        return 0;
+    }
+
+    unsigned long long lsn = estado_wal->lsn_siguiente;
+    for (int i = 0; i < num_registros; i++)
+    {
+        registros[i].lsn = lsn + i;
+        registros[i].tam_grupo = num_registros;
+        registros[i].suma = suma_registro(&registros[i]);
+    }
+
+    size_t tam = num_registros * sizeof(RegistroWal);
+    ssize_t escrito = write(fd_wal, registros, tam);
+    if (escrito != (ssize_t)tam)
+    {
+        perror("Error al escribir en cuentas.wal");
+        // con el cerrojo nadie mas aniade: el final del fichero es el de esta escritura
+        if (escrito > 0 && ftruncate(fd_wal, lseek(fd_wal, 0, SEEK_END) - escrito) == -1)
+            perror("Error al recortar cuentas.wal");
+        cerrojo_desbloquear(&estado_wal->cerrojo);
+        return 0;
+    }
+
+    estado_wal->lsn_siguiente += num_registros;
+    cerrojo_desbloquear(&estado_wal->cerrojo);
+
+    return lsn + num_registros - 1;
+}
+
+// Espera a que el registro lsn este en disco segun el modo de durabilidad
+// Se llama despues de soltar las franjas. En modo grupo el primero que llega
+// hace de lider: sincroniza todo lo escrito hasta ese momento y despierta al
+// resto, de modo que muchas operaciones comparten un mismo fdatasync
+void wal_esperar(unsigned long long lsn)
+{
+    if (lsn == 0 || modo_wal == WAL_ASINCRONO)
+        return;
+
+    if (modo_wal == WAL_SINCRONO)
+    {
+        fdatasync(fd_wal);
+        return;
+    }
+
+    cerrojo_bloquear(&estado_wal->cerrojo);
+    while (estado_wal->lsn_durable < lsn)
+    {
+        if (!estado_wal->sincronizando)
+        {
+            // lider del grupo: todo lo escrito hasta ahora entra en este fdatasync
+            seguir_rotacion();
+            unsigned long long objetivo = estado_wal->lsn_siguiente - 1;
+            estado_wal->sincronizando = 1;
+            estado_wal->pid_lider = getpid();
+            cerrojo_desbloquear(&estado_wal->cerrojo);
+
+            fdatasync(fd_wal);
+
+            cerrojo_bloquear(&estado_wal->cerrojo);
+            if (objetivo > estado_wal->lsn_durable)
+                estado_wal->lsn_durable = objetivo;
+            estado_wal->sincronizando = 0;
+            pthread_cond_broadcast(&estado_wal->condicion);
+        }
+        else if (cerrojo_esperar(&estado_wal->cerrojo, &estado_wal->condicion, 50) == ETIMEDOUT)
+        {
+            // si el lider murio a mitad de la sincronizacion otro toma el relevo
+            if (estado_wal->sincronizando && kill(estado_wal->pid_lider, 0) == -1 && errno == ESRCH)
+                estado_wal->sincronizando = 0;
+        }
+    }
+    cerrojo_desbloquear(&estado_wal->cerrojo);
+}
+
+// Lee un registro y comprueba su suma de control
+static int leer_registro(FILE *archivo, RegistroWal *registro)
+{
+    if (fread(registro, sizeof(RegistroWal), 1, archivo) != 1)
+        return -1;
+    if (registro->suma != suma_registro(registro))
+        return -1;
+    if (registro->tam_grupo < 1 || registro->tam_grupo > WAL_MAX_GRUPO)
+        return -1;
+    return 0;
+}
+
+// Recuperacion al arrancar el banco: aplica a cuentas.dat el estado de cada
+// cuenta segun el WAL, vuelca el fichero y vacia el WAL
+// Requiere persistencia_abrir(); la cola incompleta de un fallo se descarta
+// retorno del numero de registros aplicados, -1 en caso de error
+int wal_recuperar(const char *ruta)
+{
+    FILE *archivo = fopen(ruta, "r+b");
+    if (!archivo)
+        return 0; // sin WAL no hay nada que recuperar
+
+    RegistroWal grupo[WAL_MAX_GRUPO];
+    int aplicados = 0;
+
+    while (leer_registro(archivo, &grupo[0]) == 0)
+    {
+        // el grupo solo se aplica si estan todos sus registros
+        int completo = 1;
+        for (int i = 1; i < grupo[0].tam_grupo && completo; i++)
+        {
+            if (leer_registro(archivo, &grupo[i]) == -1 ||
+                grupo[i].tam_grupo != grupo[0].tam_grupo || grupo[i].lsn != grupo[0].lsn + i)
+                completo = 0;
+        }
+        if (!completo)
+            break;
+
+        for (int i = 0; i < grupo[0].tam_grupo; i++)
+        {
+            CuentaBancaria cuenta;
+            if (persistencia_buscar(grupo[i].numero_cuenta, &cuenta) == -1)
+                continue;
+
+            // se aplica el estado resultante, repetir la recuperacion no cambia nada
+            cuenta.saldo = grupo[i].saldo;
+            cuenta.num_transacciones = grupo[i].num_transacciones;
+            if (persistencia_escribir(cuenta) == 0)
+                aplicados++;
+        }
+    }
+
+    persistencia_sincronizar();
+
+    // cuentas.dat ya contiene todos los cambios, el WAL se vacia
+    if (ftruncate(fileno(archivo), 0) == -1)
+    {
+        perror("Error al vaciar cuentas.wal");
+        fclose(archivo);
+        return -1;
+    }
+    fsync(fileno(archivo));
+    fclose(archivo);
+
+    return aplicados;
+}
+
+// Sincroniza el directorio del fichero para que su rename() sobreviva a un fallo
+static void sincronizar_directorio(const char *ruta)
+{
+    char directorio[256];
+    const char *barra = strrchr(ruta, '/');
+    if (barra == NULL)
+        snprintf(directorio, sizeof(directorio), ".");
+    else
+        snprintf(directorio, sizeof(directorio), "%.*s", (int)(barra - ruta), ruta);
+
+    int fd = open(directorio, O_RDONLY);
+    if (fd != -1)
+    {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+// Copia el WAL desde la posicion desde a un fichero nuevo y lo pone en su lugar
+// Se llama con el cerrojo del WAL: nadie aniade mientras se copia la cola
+// retorno de 0 si todo va bien, -1 en caso de error (el WAL queda como estaba)
+static int rotar(const char *ruta, int fd_lectura, off_t desde)
+{
+    char temporal[256];
+    snprintf(temporal, sizeof(temporal), "%s.tmp", ruta);
+    int fd_nuevo = open(temporal, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd_nuevo == -1)
+    {
+        perror("Error al crear el WAL nuevo");
+        return -1;
+    }
+
+    char bloque[65536];
+    ssize_t leido;
+    int resultado = 0;
+    while ((leido = pread(fd_lectura, bloque, sizeof(bloque), desde)) > 0)
+    {
+        if (write(fd_nuevo, bloque, leido) != leido)
+        {
+            resultado = -1;
+            break;
+        }
+        desde += leido;
+    }
+    if (leido == -1 || resultado == -1 || fdatasync(fd_nuevo) == -1 || rename(temporal, ruta) == -1)
+    {
+        perror("Error al rotar cuentas.wal");
+        close(fd_nuevo);
+        unlink(temporal);
+        return -1;
+    }
+    close(fd_nuevo);
+    sincronizar_directorio(ruta);
+    return 0;
+}
+
+// Punto de control del banco: cuando el WAL pasa de WAL_TAM_PUNTO_CONTROL se
+// escriben todas las cuentas de la tabla en cuentas.dat, se sincroniza el
+// fichero y el WAL se queda solo con lo anotado despues.
+// Los cambios en memoria se hacen antes de anotarlos, asi que la foto de la
+// tabla tomada despues de leer el final del WAL contiene todo lo anotado hasta
+// ese punto. La cola se copia a un fichero nuevo que se pone en su lugar con
+// rename(): un fallo deja el WAL anterior completo o el nuevo, nunca ninguno.
+// Los demas procesos ven la nueva generacion y reabren el fichero.
+// Lo llama el hilo de escritura del banco, el unico escritor de cuentas.dat
+// retorno de 1 si se ha recortado, 0 si no hacia falta, -1 en caso de error
+int wal_punto_control(const char *ruta, TablaCuentas *tabla)
+{
+    struct stat st;
+    if (estado_wal == NULL || stat(ruta, &st) == -1 || st.st_size < WAL_TAM_PUNTO_CONTROL)
+        return 0;
+
+    int fd_lectura = open(ruta, O_RDONLY);
+    if (fd_lectura == -1)
+    {
+        perror("Error al abrir cuentas.wal para el punto de control");
+        return -1;
+    }
+
+    // con el cerrojo el final del fichero es exactamente lo anotado hasta ahora
+    cerrojo_bloquear(&estado_wal->cerrojo);
+    off_t desde = lseek(fd_lectura, 0, SEEK_END);
+    cerrojo_desbloquear(&estado_wal->cerrojo);
+
+    // foto de la tabla en cuentas.dat
+    CuentaBancaria lote[LOTE_PUNTO_CONTROL];
+    int num_lote = 0;
+    int num_cuentas = tabla->num_cuentas;
+    int resultado = 0;
+    for (int i = 0; i < num_cuentas; i++)
+    {
+        tabla_leer_posicion(tabla, i, &lote[num_lote++]);
+        if (num_lote == LOTE_PUNTO_CONTROL || i == num_cuentas - 1)
+        {
+            if (persistencia_escribir_lote(lote, num_lote) == -1)
+                resultado = -1;
+            num_lote = 0;
+        }
+    }
+    persistencia_sincronizar();
+    if (resultado == -1)
+    {
+        close(fd_lectura);
+        return -1;
+    }
+
+    cerrojo_bloquear(&estado_wal->cerrojo);
+    if (rotar(ruta, fd_lectura, desde) == 0)
+    {
+        // la cola copiada ya esta en disco
+        if (estado_wal->lsn_durable < estado_wal->lsn_siguiente - 1)
+            estado_wal->lsn_durable = estado_wal->lsn_siguiente - 1;
+        estado_wal->generacion++;
+        if (fd_wal != -1)
+            seguir_rotacion();
+        pthread_cond_broadcast(&estado_wal->condicion);
+        resultado = 1;
+    }
+    else
+    {
+        resultado = -1;
+    }
+    cerrojo_desbloquear(&estado_wal->cerrojo);
+    close(fd_lectura);
+    return resultado;
+}
@@ -0,0 +1,57 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include <sys/types.h>
+#include "cerrojo.h"
+#include "tabla_cuentas.h"
+
+#define WAL "cuentas.wal"                 // Registro de escritura anticipada de saldos
+#define NOMBRE_SHM_WAL "/secure_bank_wal" // Estado compartido del commit en grupo
+#define WAL_MAX_GRUPO 4                    // Registros maximos de una misma operacion
+#define WAL_TAM_PUNTO_CONTROL (16 * 1024 * 1024) // Tamanio del WAL a partir del cual se recorta
+
+// Modos de durabilidad (DURABILIDAD en config.txt)
+#define WAL_SINCRONO 0  // cada operacion hace su propio fdatasync
+#define WAL_GRUPO 1     // las operaciones concurrentes comparten el fdatasync
+#define WAL_ASINCRONO 2 // no se espera al disco, lo vuelca el kernel
+
+// Registro del WAL: cambio de saldo de una cuenta y su estado resultante
+// Los registros de una misma operacion (origen y destino de una transferencia)
+// se escriben juntos y forman un grupo; en la recuperacion solo se aplican
+// los grupos completos y con la suma de control correcta
+typedef struct
+{
+    unsigned long long lsn; // numero de secuencia del registro
+    int numero_cuenta;
+    float delta;            // cambio aplicado al saldo
+    float saldo;            // saldo resultante
+    int num_transacciones;  // contador resultante
+    int tam_grupo;          // registros de la operacion a la que pertenece
+    unsigned int suma;      // suma de control del registro
+} RegistroWal;
+
+// Estado compartido del commit en grupo
+typedef struct
+{
+    Cerrojo cerrojo;
+    pthread_cond_t condicion;         // aviso de nuevo lsn durable
+    unsigned long long lsn_siguiente; // proximo lsn a asignar
+    unsigned long long lsn_durable;   // todo lsn menor o igual esta en disco
+    int sincronizando;                // hay un lider haciendo fdatasync
+    pid_t pid_lider;
+    unsigned long generacion;         // sube cada vez que se rota el fichero del WAL
+} EstadoWal;
+
+int wal_modo(const char *nombre);
+int wal_crear_estado();
+int wal_abrir(const char *ruta, int modo);
+void wal_cerrar();
+
+void wal_preparar(RegistroWal *registro, const CuentaBancaria *cuenta, float delta);
+unsigned long long wal_anotar(RegistroWal *registros, int num_registros);
+void wal_esperar(unsigned long long lsn);
+
+int wal_recuperar(const char *ruta);
+int wal_punto_control(const char *ruta, TablaCuentas *tabla);
+
+#endif